@@ -2095,6 +2095,9 @@ static bool matchMultilineRegexPattern (struct lregexControlBlock *lcb,
 	current = start = vStringValue (allLines);
 	do
 	{
+		if (isInputInterrupted ())
+			break;
+
 		match = patbuf->pattern.backend->match (patbuf->pattern.backend,
 												patbuf->pattern.code, current,
 												vStringLength (allLines) - (current - start),
@@ -3203,7 +3206,7 @@ extern bool matchMultitableRegex (struct lregexControlBlock *lcb, const vString*
 	unsigned int last_offset;
 
 
-	while (table)
+	while (table && !isInputInterrupted ())
 	{
 		last_offset = offset;
 		table = matchMultitableRegexTable(lcb, table, allLines, &offset);
@@ -147,10 +147,28 @@ static inputFile File;  /* static read through functions */
 static inputFile BackupFile;	/* File is copied here when a guest parser is pushed */
 static compoundPos StartOfLine;  /* holds deferred position of start of line */
 
+static inputInterruptCheck InterruptCheck;
+static void *InterruptCheckData;
+static bool Interrupted;
+
 /*
 *   FUNCTION DEFINITIONS
 */
 
+extern void setInputInterruptCheck (inputInterruptCheck check, void *data)
+{
+	InterruptCheck = check;
+	InterruptCheckData = data;
+	Interrupted = false;
+}
+
+extern bool isInputInterrupted (void)
+{
+	if (!Interrupted && InterruptCheck)
+		Interrupted = InterruptCheck (InterruptCheckData);
+	return Interrupted;
+}
+
 extern unsigned long getInputLineNumber (void)
 {
 	if (!File.currentLine && File.input.lineNumber == 1 && isAreaStacked ())
@@ -1166,6 +1184,19 @@ static vString *iFileGetLine (bool chop_newline)
 	langType lang = getInputLanguage();
 
 	Assert (File.line);
+
+	if (isInputInterrupted ())
+	{
+		/* pretend the input ends here, without running the regex
+		   patterns on the whole input */
+		if (File.allLines)
+		{
+			vStringDelete (File.allLines);
+			File.allLines = NULL;
+		}
+		return NULL;
+	}
+
 	eol = readLine (File.line, File.mio);
 
 	if (vStringLength (File.line) > 0)
@@ -1206,7 +1237,7 @@ static vString *iFileGetLine (bool chop_newline)
 				MIOPos pos = File.filePosition.pos;
 
 				vString *line = vStringNew();
-				for (size_t i = 0; i < File.lineFposMap.count; i++)
+				for (size_t i = 0; i < File.lineFposMap.count && !isInputInterrupted (); i++)
 				{
 					File.input.lineNumber = i + 1;
 					File.source.lineNumber = File.input.lineNumber;
@@ -27,6 +27,9 @@ enum areaBoundaryFlag {
 	AREA_BOUNDARY_END   = 1UL << 1,
 };
 
+/* Returns true when the parse should stop, see setInputInterruptCheck() */
+typedef bool (* inputInterruptCheck) (void *data);
+
 /*
 *   FUNCTION PROTOTYPES
 */
@@ -110,4 +113,10 @@ extern void getAreaInfo (unsigned long *startLine,
 						 unsigned long *endLine,
 						 long *endColumn);
 
+/* Once CHECK returns true, the input appears to end so the running parser
+ * finishes with the tags found so far. CHECK is called for every input line
+ * and should be cheap. */
+extern void setInputInterruptCheck (inputInterruptCheck check, void *data);
+extern bool isInputInterrupted (void);
+
 #endif  /* CTAGS_MAIN_READ_PRIVATE_H */
@@ -158,7 +158,8 @@ static guint build_groups_count[GEANY_GBG_COUNT] = { 3, 4, 2 };
 static guint build_items_count = 9;
 
 static void build_exit_cb(GPid pid, gint status, gpointer user_data);
-static void build_iofunc(GString *string, GIOCondition condition, gpointer data);
+static void build_iofunc(const SpawnLine *lines, guint n_lines, GIOCondition condition,
+	gpointer data);
 #ifndef G_OS_WIN32
 static gchar *build_create_shellscript(const gchar *working_dir, const gchar *cmd, gboolean autoclose, GError **error);
 #endif
@@ -733,9 +734,7 @@ static void build_spawn_cmd(GeanyDocument *doc, const gchar *cmd, const gchar *d
 	utf8_working_dir = !EMPTY(dir) ? g_strdup(dir) : g_path_get_dirname(doc->file_name);
 	working_dir = utils_get_locale_from_utf8(utf8_working_dir);
 
-	gtk_list_store_clear(msgwindow.store_compiler);
-	// reset width after any long error messages
-	gtk_tree_view_columns_autosize(GTK_TREE_VIEW(msgwindow.tree_compiler));
+	msgwin_clear_tab(MSG_COMPILER);
 	gtk_notebook_set_current_page(GTK_NOTEBOOK(msgwindow.notebook), MSG_COMPILER);
 	msgwin_compiler_add(COLOR_BLUE, _("%s (in directory: %s)"), cmd, utf8_working_dir);
 	g_free(utf8_working_dir);
@@ -757,9 +756,9 @@ static void build_spawn_cmd(GeanyDocument *doc, const gchar *cmd, const gchar *d
 	build_info.file_type_id = (doc == NULL) ? GEANY_FILETYPES_NONE : doc->file_type->id;
 	build_info.message_count = 0;
 
-	if (!spawn_with_callbacks(working_dir, cmd, (gchar **) argv, NULL, 0, NULL, NULL, build_iofunc,
-		GINT_TO_POINTER(0), 0, build_iofunc, GINT_TO_POINTER(1), 0, build_exit_cb, NULL,
-		&build_info.pid, &error))
+	if (!spawn_with_line_callbacks(working_dir, cmd, (gchar **) argv, NULL, 0, NULL, NULL,
+		build_iofunc, GINT_TO_POINTER(0), 0, build_iofunc, GINT_TO_POINTER(1), 0, build_exit_cb,
+		NULL, &build_info.pid, &error))
 	{
 		geany_debug("build command spawning failed: %s", error->message);
 		ui_set_statusbar(TRUE, _("Process failed (%s)"), error->message);
@@ -983,12 +982,23 @@ static void process_build_output_line(gchar *msg, gint color)
 }
 
 
-static void build_iofunc(GString *string, GIOCondition condition, gpointer data)
+static void build_iofunc(const SpawnLine *lines, guint n_lines, GIOCondition condition,
+	gpointer data)
 {
 	if (condition & (G_IO_IN | G_IO_PRI))
 	{
-		process_build_output_line(string->str,
-			(GPOINTER_TO_INT(data)) ? COLOR_DARK_RED : COLOR_BLACK);
+		gint color = GPOINTER_TO_INT(data) ? COLOR_DARK_RED : COLOR_BLACK;
+		GString *msg = g_string_sized_new(256);
+		guint i;
+
+		for (i = 0; i < n_lines; i++)
+		{
+			/* process_build_output_line() needs a modifiable, nul-terminated copy */
+			g_string_truncate(msg, 0);
+			g_string_append_len(msg, lines[i].text, lines[i].length);
+			process_build_output_line(msg->str, color);
+		}
+		g_string_free(msg, TRUE);
 	}
 }
 
@@ -396,6 +396,13 @@ static void do_toolbar_search(const gchar *text, gboolean incremental, gboolean
 	gboolean result;
 
 	setup_find(text, backwards);
+	if (incremental && ! backwards)
+	{
+		/* sets the entry background itself, possibly later */
+		search_find_incremental(doc, search_data.text);
+		return;
+	}
+	search_find_incremental_cancel();
 	result = document_search_bar_find(doc, search_data.text, incremental, backwards);
 	if (search_data.search_bar)
 		ui_set_search_entry_background(toolbar_get_widget_child_by_name("SearchEntry"), result);
@@ -405,6 +412,7 @@ static void do_toolbar_search(const gchar *text, gboolean incremental, gboolean
 /* search text */
 void on_toolbar_search_entry_changed(GtkAction *action, const gchar *text, gpointer user_data)
 {
+	search_mark_all_cancel();
 	do_toolbar_search(text, TRUE, FALSE);
 }
 
@@ -574,6 +582,9 @@ static void handle_switch_page(GeanyDocument *doc)
 		else
 			sidebar_update_tag_list(doc, TRUE);
 		document_highlight_tags(doc);
+		/* background documents are reparsed once they get visible */
+		if (doc->priv->tag_list_update_pending)
+			document_update_tag_list_in_idle(doc);
 
 		document_check_disk_status(doc, TRUE);
 
@@ -1051,6 +1062,12 @@ void on_go_to_line_activate(GtkMenuItem *menuitem, gpointer user_data)
 }
 
 
+static void on_go_to_symbol_activate(GtkMenuItem *menuitem, gpointer user_data)
+{
+	symbols_show_goto_symbol_dialog();
+}
+
+
 void on_toolbutton_goto_entry_activate(GtkAction *action, const gchar *text, gpointer user_data)
 {
 	GeanyDocument *doc = document_get_current();
@@ -1595,6 +1612,7 @@ void on_remove_markers1_activate(GtkMenuItem *menuitem, gpointer user_data)
 
 	sci_marker_delete_all(doc->editor->sci, 0);	/* delete the yellow tag marker */
 	sci_marker_delete_all(doc->editor->sci, 1);	/* delete user markers */
+	search_mark_all_cancel();
 	editor_indicator_clear(doc->editor, GEANY_INDICATOR_SEARCH);
 }
 
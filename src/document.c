@@ -2184,6 +2184,28 @@ gboolean document_save_file(GeanyDocument *doc, gboolean force)
 }
 
 
+/* Selects a match found with the search bar and scrolls to it */
+void document_show_search_bar_match(GeanyDocument *doc, gint start, gint end)
+{
+	gint line = sci_get_line_from_position(doc->editor->sci, start);
+
+	/* unfold maybe folded results */
+	sci_ensure_line_is_visible(doc->editor->sci, line);
+
+	sci_set_selection_start(doc->editor->sci, start);
+	sci_set_selection_end(doc->editor->sci, end);
+
+	if (! editor_line_in_view(doc->editor, line))
+	{	/* we need to force scrolling in case the cursor is outside of the current visible area
+		 * GeanyDocument::scroll_percent doesn't work because sci isn't always updated
+		 * while searching */
+		editor_scroll_to_line(doc->editor, -1, 0.3F);
+	}
+	else
+		sci_scroll_caret(doc->editor->sci); /* may need horizontal scrolling */
+}
+
+
 /* special search function, used from the find entry in the toolbar
  * return TRUE if text was found otherwise FALSE
  * return also TRUE if text is empty  */
@@ -2225,22 +2247,7 @@ gboolean document_search_bar_find(GeanyDocument *doc, const gchar *text, gboolea
 
 	if (search_pos != -1)
 	{
-		gint line = sci_get_line_from_position(doc->editor->sci, ttf.chrgText.cpMin);
-
-		/* unfold maybe folded results */
-		sci_ensure_line_is_visible(doc->editor->sci, line);
-
-		sci_set_selection_start(doc->editor->sci, ttf.chrgText.cpMin);
-		sci_set_selection_end(doc->editor->sci, ttf.chrgText.cpMax);
-
-		if (! editor_line_in_view(doc->editor, line))
-		{	/* we need to force scrolling in case the cursor is outside of the current visible area
-			 * GeanyDocument::scroll_percent doesn't work because sci isn't always updated
-			 * while searching */
-			editor_scroll_to_line(doc->editor, -1, 0.3F);
-		}
-		else
-			sci_scroll_caret(doc->editor->sci); /* may need horizontal scrolling */
+		document_show_search_bar_match(doc, ttf.chrgText.cpMin, ttf.chrgText.cpMax);
 		return TRUE;
 	}
 	else
@@ -2586,20 +2593,89 @@ gint document_replace_all(GeanyDocument *doc, const gchar *find_text, const gcha
 }
 
 
+/* Upper limit of the delay of tag updates for documents which are slow to parse */
+#define TAG_UPDATE_MAX_DELAY 5000
+/* Delay of tag updates for documents whose parsing keeps exceeding the
+ * symbol_parse_time_limit pref */
+#define TAG_UPDATE_DEMOTED_DELAY 30000
+/* Number of consecutive parses exceeding the time limit before a document is
+ * parsed less often */
+#define TAG_UPDATE_DEMOTE_OVERRUNS 2
+
+
+/* Gets the delay between a modification and the tag update. Documents which
+ * take long to parse get a longer delay so that parsing takes at most about
+ * a quarter of the time while typing. */
+static guint get_tag_update_delay(GeanyDocument *doc)
+{
+	guint delay = (guint) editor_prefs.autocompletion_update_freq;
+	guint cost = (guint) doc->priv->tag_parse_duration / 1000 * 4;
+
+	if (doc->tm_file && tm_source_file_get_overruns(doc->tm_file) >= TAG_UPDATE_DEMOTE_OVERRUNS)
+		return MAX(delay, TAG_UPDATE_DEMOTED_DELAY);
+
+	return MAX(delay, MIN(cost, TAG_UPDATE_MAX_DELAY));
+}
+
+
+/* Records the parse time of the document, smoothed like Scintilla's
+ * ActionDuration so that a single slow parse doesn't change much */
+static void update_tag_parse_duration(GeanyDocument *doc)
+{
+	gint parse_time = tm_source_file_get_parse_time(doc->tm_file);
+
+	if (parse_time < 0)
+		return;
+
+	if (tm_source_file_get_overruns(doc->tm_file) == 1)
+		ui_set_statusbar(TRUE, _("Parsing the symbols of %s took too long, the symbol list is incomplete."),
+			DOC_FILENAME(doc));
+
+	if (doc->priv->tag_parse_duration == 0)
+		doc->priv->tag_parse_duration = MAX(parse_time, 1);
+	else
+		doc->priv->tag_parse_duration = (gint) (((gint64) doc->priv->tag_parse_duration * 3 +
+			parse_time) / 4);
+
+	geany_debug("Parsed symbols of %s in %.1f ms (average %.1f ms, update delay %u ms)",
+		DOC_FILENAME(doc), parse_time / 1000.0, doc->priv->tag_parse_duration / 1000.0,
+		get_tag_update_delay(doc));
+}
+
+
+/* Called once the tag manager has merged the new tags of the document */
+static void on_document_tags_parsed(TMSourceFile *source_file, gpointer user_data)
+{
+	GeanyDocument *doc = user_data;
+
+	/* the document might have been closed or reused for another file meanwhile */
+	if (! DOC_VALID(doc) || doc->tm_file != source_file)
+		return;
+
+	update_tag_parse_duration(doc);
+
+	sidebar_update_tag_list(doc, TRUE);
+	document_highlight_tags(doc);
+}
+
+
 /*
  * Parses or re-parses the document's buffer and updates the type
- * keywords and symbol list.
+ * keywords and symbol list. Depending on the symbol_parse_workers preference,
+ * parsing may happen in the background and the symbol list and type keywords
+ * are updated once it finishes.
  *
  * @param doc The document.
  */
 void document_update_tags(GeanyDocument *doc)
 {
-	guchar *buffer_ptr;
-	gsize len;
+	GBytes *contents;
 
 	g_return_if_fail(DOC_VALID(doc));
 	g_return_if_fail(app->tm_workspace != NULL);
 
+	doc->priv->tag_list_update_pending = FALSE;
+
 	/* early out if it's a new file or doesn't support tags */
 	if (! doc->file_name || ! doc->file_type || !filetype_has_tags(doc->file_type))
 	{
@@ -2635,21 +2711,30 @@ void document_update_tags(GeanyDocument *doc)
 		return;
 	}
 
-	/* Parse Scintilla's buffer directly using TagManager
-	 * Note: this buffer *MUST NOT* be modified */
-	len = sci_get_length(doc->editor->sci);
-	buffer_ptr = (guchar *) SSM(doc->editor->sci, SCI_GETCHARACTERPOINTER, 0, 0);
-	tm_workspace_update_source_file_buffer(doc->tm_file, buffer_ptr, len);
+	/* Parse Scintilla's buffer using TagManager. A background parse gets a copy
+	 * so the document can be edited in the meantime, a synchronous one uses the
+	 * buffer directly to avoid the copy. Unchanged documents can use the tag cache.
+	 * Note: the buffer *MUST NOT* be modified */
+	if (tm_workspace_parses_in_background(doc->tm_file))
+		contents = sci_get_contents_bytes(doc->editor->sci);
+	else
+	{
+		gsize len = sci_get_length(doc->editor->sci);
+		gconstpointer buffer_ptr = (gconstpointer) SSM(doc->editor->sci, SCI_GETCHARACTERPOINTER, 0, 0);
 
-	sidebar_update_tag_list(doc, TRUE);
-	document_highlight_tags(doc);
+		contents = g_bytes_new_static(buffer_ptr, len);
+	}
+	tm_workspace_update_source_file_buffer_async(doc->tm_file, contents,
+		! doc->changed, on_document_tags_parsed, doc);
+	g_bytes_unref(contents);
 }
 
 
 /* Re-highlights type keywords without re-parsing the whole document. */
 void document_highlight_tags(GeanyDocument *doc)
 {
-	GString *keywords_str;
+	const gchar *keywords;
+	guint version;
 	gint keyword_idx;
 
 	if (plugin_extension_symbol_highlight_provided(doc, NULL))
@@ -2686,20 +2771,14 @@ void document_highlight_tags(GeanyDocument *doc)
 		return;
 
 	/* get any type keywords and tell scintilla about them
-	 * this will cause the type keywords to be colourized in scintilla */
-	keywords_str = symbols_find_typenames_as_string(doc->file_type->lang, FALSE);
-	if (keywords_str)
+	 * this will cause the type keywords to be colourized in scintilla;
+	 * only done when the typenames of the language changed */
+	keywords = symbols_get_typename_keywords(doc->file_type->lang, &version);
+	if (keywords && version != doc->priv->keyword_version)
 	{
-		gchar *keywords = g_string_free(keywords_str, FALSE);
-		guint hash = g_str_hash(keywords);
-
-		if (hash != doc->priv->keyword_hash)
-		{
-			sci_set_keywords(doc->editor->sci, keyword_idx, keywords);
-			queue_colourise(doc); /* force re-highlighting the entire document */
-			doc->priv->keyword_hash = hash;
-		}
-		g_free(keywords);
+		sci_set_keywords(doc->editor->sci, keyword_idx, keywords);
+		queue_colourise(doc); /* force re-highlighting the entire document */
+		doc->priv->keyword_version = version;
 	}
 }
 
@@ -2728,10 +2807,21 @@ void document_update_tag_list_in_idle(GeanyDocument *doc)
 
 	/* prevent "stacking up" callback handlers, we only need one to run soon */
 	if (doc->priv->tag_list_update_source != 0)
+	{
 		g_source_remove(doc->priv->tag_list_update_source);
+		doc->priv->tag_list_update_source = 0;
+	}
+
+	/* don't spend time on documents which aren't visible, they get updated
+	 * when they are activated */
+	if (doc != document_get_current())
+	{
+		doc->priv->tag_list_update_pending = TRUE;
+		return;
+	}
 
 	doc->priv->tag_list_update_source = g_timeout_add_full(G_PRIORITY_LOW,
-		editor_prefs.autocompletion_update_freq, on_document_update_tag_list_idle, doc, NULL);
+		get_tag_update_delay(doc), on_document_update_tag_list_idle, doc, NULL);
 }
 
 
@@ -2763,7 +2853,7 @@ static void document_load_config(GeanyDocument *doc, GeanyFiletype *type,
 		queue_colourise(doc);
 		/* forces re-setting SCI_SETKEYWORDS which seems to be needed with
 		 * Scintilla 5 to colorize them properly */
-		doc->priv->keyword_hash = 0;
+		doc->priv->keyword_version = 0;
 		if (type->priv->symbol_list_sort_mode == SYMBOLS_SORT_USE_PREVIOUS)
 			doc->priv->symbol_list_sort_mode = interface_prefs.symbols_sort_mode;
 		else
@@ -257,6 +257,8 @@ void document_open_file_list(const gchar *data, gsize length);
 gboolean document_search_bar_find(GeanyDocument *doc, const gchar *text, gboolean inc,
 		gboolean backwards);
 
+void document_show_search_bar_match(GeanyDocument *doc, gint start, gint end);
+
 gint document_find_text(GeanyDocument *doc, const gchar *text, const gchar *original_text,
 		GeanyFindFlags flags, gboolean search_backwards, GeanyMatchInfo **match_,
 		gboolean scroll);
@@ -90,7 +90,7 @@ typedef struct GeanyDocumentPrivate
 	/* Used so Undo/Redo works for encoding changes. */
 	FileEncoding	 saved_encoding;
 	gboolean		 colourise_needed;	/* use document.c:queue_colourise() instead */
-	guint			 keyword_hash;	/* hash of keyword string used for typename colourisation */
+	guint			 keyword_version;	/* version of the typenames used for colourisation */
 	gint			 line_count;		/* Number of lines in the document. */
 	gint			 symbol_list_sort_mode;
 	/* indicates whether a file is on a remote filesystem, works only with GIO/GVfs */
@@ -105,6 +105,10 @@ typedef struct GeanyDocumentPrivate
 	time_t			 mtime;
 	/* ID of the idle callback updating the tag list */
 	guint			 tag_list_update_source;
+	/* Whether the tag list update waits for the document to become visible */
+	gboolean		 tag_list_update_pending;
+	/* Smoothed time of parsing the document for tags in microseconds */
+	gint			 tag_parse_duration;
 	/* Whether it's temporarily protected (read-only and saving needs confirmation). Does
 	 * not imply doc->readonly as writable files can be protected */
 	gint			 protected;
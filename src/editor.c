@@ -605,7 +605,10 @@ static void check_line_breaking(GeanyEditor *editor, gint pos)
 }
 
 
-static void show_autocomplete(ScintillaObject *sci, gsize rootlen, GString *words)
+/* With fuzzy, the words don't necessarily start with the typed text and the
+ * first word gets selected */
+static void show_autocomplete(ScintillaObject *sci, gsize rootlen, GString *words,
+	gboolean fuzzy)
 {
 	/* hide autocompletion if only option is already typed */
 	if (rootlen >= words->len ||
@@ -617,11 +620,21 @@ static void show_autocomplete(ScintillaObject *sci, gsize rootlen, GString *word
 	/* store whether a calltip is showing, so we can reshow it after autocompletion */
 	calltip.set = (gboolean) SSM(sci, SCI_CALLTIPACTIVE, 0, 0);
 	SSM(sci, SCI_AUTOCSETORDER, SC_ORDER_CUSTOM, 0);
+	/* Scintilla would hide a list in which no word starts with the typed text */
+	SSM(sci, SCI_AUTOCSETAUTOHIDE, !fuzzy, 0);
 	SSM(sci, SCI_AUTOCSHOW, rootlen, (sptr_t) words->str);
+	if (fuzzy && SSM(sci, SCI_AUTOCACTIVE, 0, 0))
+	{
+		gchar *first = g_strndup(words->str, strcspn(words->str, "?\n"));
+
+		SSM(sci, SCI_AUTOCSELECT, 0, (sptr_t) first);
+		g_free(first);
+	}
 }
 
 
-static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, gsize rootlen)
+static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, gsize rootlen,
+	gboolean fuzzy)
 {
 	ScintillaObject *sci = editor->sci;
 
@@ -656,7 +669,7 @@ static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, gsize roo
 				g_string_append(words, buf);
 			}
 		}
-		show_autocomplete(sci, rootlen, words);
+		show_autocomplete(sci, rootlen, words, fuzzy);
 		g_string_free(words, TRUE);
 	}
 }
@@ -796,7 +809,7 @@ static gboolean autocomplete_scope(GeanyEditor *editor, const gchar *root, gsize
 
 		if (filtered->len > 0)
 		{
-			show_tags_list(editor, filtered, rootlen);
+			show_tags_list(editor, filtered, rootlen, FALSE);
 			ret = TRUE;
 		}
 
@@ -2097,11 +2110,15 @@ autocomplete_tags(GeanyEditor *editor, GeanyFiletype *ft, const gchar *root, gsi
 	symbols_get_current_function(doc, &current_scope);
 	current_line = sci_get_current_line(editor->sci) + 1;
 
-	tags = tm_workspace_find_prefix(root, doc->tm_file, current_line, current_scope,
-		editor_prefs.autocompletion_max_entries);
+	if (editor_prefs.autocompletion_fuzzy)
+		tags = tm_workspace_find_fuzzy(root, doc->tm_file, current_line, current_scope,
+			editor_prefs.autocompletion_max_entries);
+	else
+		tags = tm_workspace_find_prefix(root, doc->tm_file, current_line, current_scope,
+			editor_prefs.autocompletion_max_entries);
 	found = tags->len > 0;
 	if (found)
-		show_tags_list(editor, tags, rootlen);
+		show_tags_list(editor, tags, rootlen, editor_prefs.autocompletion_fuzzy);
 	g_ptr_array_free(tags, TRUE);
 
 	return found;
@@ -2228,7 +2245,7 @@ static gboolean autocomplete_doc_word(GeanyEditor *editor, gchar *root, gsize ro
 
 	g_slist_free(words);
 
-	show_autocomplete(sci, rootlen, str);
+	show_autocomplete(sci, rootlen, str, FALSE);
 	g_string_free(str, TRUE);
 	return TRUE;
 }
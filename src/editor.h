@@ -142,6 +142,12 @@ typedef struct GeanyEditorPrefs
 	gboolean	show_line_endings_only_when_differ;
 	gboolean	change_history_markers;
 	gboolean	change_history_indicators;
+	gint		symbol_parse_workers;	/* hidden pref */
+	gint		symbol_cache_size;	/* hidden pref, in MiB */
+	gint		symbol_parse_time_limit;	/* hidden pref, in milliseconds */
+	gboolean	autocompletion_fuzzy;	/* hidden pref */
+	gint		autocompletion_include_depth;	/* hidden pref */
+	gint		project_index_max_files;	/* hidden pref */
 }
 GeanyEditorPrefs;
 
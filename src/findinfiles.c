@@ -0,0 +1,819 @@
+/*
+ *      findinfiles.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * The built-in Find in Files engine. Directories and files are searched by jobs on
+ * a thread pool, each directory job queueing jobs for its files and subdirectories.
+ * Files are mapped into memory and searched as a whole: literal searches first look
+ * for candidate lines with memchr() and only run the regex on those, regex searches
+ * make a single pass over the file. Binary files, symbolic links and the paths
+ * ignored by .gitignore files are skipped. The matching lines are collected per file
+ * and passed to the main thread in batches from a timeout.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "findinfiles.h"
+
+#include "main.h"
+#include "utils.h"
+
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+
+/* number of bytes at the start of a file checked for NUL bytes to detect binary files */
+#define BINARY_CHECK_SIZE 8192
+/* maximum number of bytes of a line kept for a match */
+#define MAX_LINE_LENGTH 1024
+/* interval in milliseconds in which the results are passed to the main thread */
+#define FLUSH_INTERVAL 100
+/* maximum number of matches passed to the main thread per interval */
+#define FLUSH_BATCH_SIZE 2000
+
+
+typedef struct IgnorePattern
+{
+	GPatternSpec *spec;
+	gboolean negated;
+	gboolean dir_only;
+	gboolean anchored;	/* matched against the path relative to the .gitignore file */
+}
+IgnorePattern;
+
+/* The patterns of the .gitignore file of a directory, linked to the ones of its parents */
+typedef struct IgnoreRules
+{
+	gint refcount;
+	struct IgnoreRules *parent;
+	gchar *dir;	/* relative to the searched directory, "" for itself */
+	GPtrArray *patterns;
+}
+IgnoreRules;
+
+/* The matches of a file */
+typedef struct FileResults
+{
+	gchar *file;
+	GArray *matches;	/* FifMatch */
+}
+FileResults;
+
+typedef struct FifSearch
+{
+	gchar *dir;
+	gchar *encoding;
+	FifOptions options;
+	GPtrArray *file_patterns;	/* GPatternSpec, NULL for all files */
+	GRegex *regex;
+	gchar *literal;	/* text for the literal prefilter, NULL for regex and inverted searches */
+	gsize literal_len;
+
+	GThreadPool *pool;
+	gint pending;	/* number of queued and running jobs, accessed atomically */
+	gint cancelled;	/* accessed atomically */
+
+	GMutex lock;
+	GPtrArray *results;	/* FileResults, protected by lock */
+
+	/* only used by the main thread */
+	GPtrArray *delivering;	/* FileResults taken from results */
+	guint delivered_files;
+	guint delivered_matches;	/* passed matches of the first file not completely passed */
+	guint n_matches;
+	guint flush_id;
+	FifMatchesFunc matches_cb;
+	FifFinishedFunc finished_cb;
+	gpointer user_data;
+}
+FifSearch;
+
+typedef struct FifJob
+{
+	gchar *path;	/* relative to the searched directory, "" for itself */
+	gboolean is_dir;
+	IgnoreRules *rules;	/* the rules for the directory contents, only for directories */
+}
+FifJob;
+
+typedef struct LineCounter
+{
+	const gchar *pos;	/* the position up to which lines are counted */
+	const gchar *line_start;
+	guint line;
+}
+LineCounter;
+
+
+/* the search whose results are shown */
+static FifSearch *current_search = NULL;
+/* all searches still having jobs or results, including cancelled ones */
+static GList *searches = NULL;
+
+
+static IgnoreRules *ignore_rules_ref(IgnoreRules *rules)
+{
+	if (rules != NULL)
+		g_atomic_int_inc(&rules->refcount);
+	return rules;
+}
+
+
+static void ignore_rules_unref(IgnoreRules *rules)
+{
+	while (rules != NULL && g_atomic_int_dec_and_test(&rules->refcount))
+	{
+		IgnoreRules *parent = rules->parent;
+
+		g_ptr_array_free(rules->patterns, TRUE);
+		g_free(rules->dir);
+		g_free(rules);
+		rules = parent;
+	}
+}
+
+
+static void ignore_pattern_free(gpointer data)
+{
+	IgnorePattern *pattern = data;
+
+	g_pattern_spec_free(pattern->spec);
+	g_free(pattern);
+}
+
+
+/* Supports the common subset of the .gitignore syntax: comments, negation with '!',
+ * directory only patterns with a trailing '/', patterns anchored to the directory
+ * of the .gitignore file by a '/' and a leading "**" directory. Wildcards are matched by
+ * GPatternSpec, so '*' also matches '/' and character classes are not supported. */
+static IgnorePattern *ignore_pattern_new(gchar *text)
+{
+	IgnorePattern *pattern;
+	gboolean negated = FALSE;
+	gboolean dir_only = FALSE;
+	gboolean anchored = FALSE;
+	gsize len;
+
+	g_strchomp(text);
+	if (*text == 0 || *text == '#')
+		return NULL;
+
+	if (*text == '!')
+	{
+		negated = TRUE;
+		text++;
+	}
+	else if (*text == '\\')	/* escaped leading '#' or '!' */
+		text++;
+
+	len = strlen(text);
+	if (len > 0 && text[len - 1] == '/')
+	{
+		dir_only = TRUE;
+		text[len - 1] = 0;
+	}
+
+	if (g_str_has_prefix(text, "**/"))
+		text += 3;
+	else if (strchr(text, '/') != NULL)
+	{
+		anchored = TRUE;
+		if (*text == '/')
+			text++;
+	}
+	if (*text == 0)
+		return NULL;
+
+	pattern = g_new(IgnorePattern, 1);
+	pattern->spec = g_pattern_spec_new(text);
+	pattern->negated = negated;
+	pattern->dir_only = dir_only;
+	pattern->anchored = anchored;
+	return pattern;
+}
+
+
+/* Returns the rules for the contents of the directory path, with a new reference. */
+static IgnoreRules *ignore_rules_read(IgnoreRules *parent, const gchar *path, const gchar *full_path)
+{
+	gchar *file_name = g_build_filename(full_path, ".gitignore", NULL);
+	gchar *contents;
+	gchar **lines, **line;
+	IgnoreRules *rules;
+
+	if (! g_file_get_contents(file_name, &contents, NULL, NULL))
+	{
+		g_free(file_name);
+		return ignore_rules_ref(parent);
+	}
+	g_free(file_name);
+
+	rules = g_new(IgnoreRules, 1);
+	rules->refcount = 1;
+	rules->parent = ignore_rules_ref(parent);
+	rules->dir = g_strdup(path);
+	rules->patterns = g_ptr_array_new_with_free_func(ignore_pattern_free);
+
+	lines = g_strsplit(contents, "\n", -1);
+	foreach_strv(line, lines)
+	{
+		IgnorePattern *pattern = ignore_pattern_new(*line);
+
+		if (pattern != NULL)
+			g_ptr_array_add(rules->patterns, pattern);
+	}
+	g_strfreev(lines);
+	g_free(contents);
+	return rules;
+}
+
+
+/* The last matching pattern decides, and the patterns of the .gitignore files nearer
+ * to the path take precedence. */
+static gboolean is_ignored(IgnoreRules *rules, const gchar *path, const gchar *name, gboolean is_dir)
+{
+	for (; rules != NULL; rules = rules->parent)
+	{
+		const gchar *rel_path = path;
+		guint i;
+
+		if (*rules->dir)
+			rel_path += strlen(rules->dir) + 1;
+
+		for (i = rules->patterns->len; i-- > 0;)
+		{
+			IgnorePattern *pattern = rules->patterns->pdata[i];
+
+			if (pattern->dir_only && ! is_dir)
+				continue;
+			if (g_pattern_match_string(pattern->spec, pattern->anchored ? rel_path : name))
+				return ! pattern->negated;
+		}
+	}
+	return FALSE;
+}
+
+
+static void file_results_free(gpointer data)
+{
+	FileResults *results = data;
+	guint i;
+
+	for (i = 0; i < results->matches->len; i++)
+		g_free((gchar *) g_array_index(results->matches, FifMatch, i).text);
+	g_array_free(results->matches, TRUE);
+	g_free(results->file);
+	g_free(results);
+}
+
+
+static void push_job(FifSearch *search, gchar *path, gboolean is_dir, IgnoreRules *rules)
+{
+	FifJob *job = g_new(FifJob, 1);
+
+	job->path = path;
+	job->is_dir = is_dir;
+	job->rules = ignore_rules_ref(rules);
+
+	g_atomic_int_inc(&search->pending);
+	g_thread_pool_push(search->pool, job, NULL);
+}
+
+
+static gboolean match_file_patterns(FifSearch *search, const gchar *name)
+{
+	guint i;
+
+	if (search->file_patterns == NULL)
+		return TRUE;
+
+	for (i = 0; i < search->file_patterns->len; i++)
+	{
+		if (g_pattern_match_string(search->file_patterns->pdata[i], name))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+
+static void search_dir(FifSearch *search, const gchar *path, IgnoreRules *parent_rules)
+{
+	gchar *full_path = g_build_filename(search->dir, path, NULL);
+	GDir *dir = g_dir_open(full_path, 0, NULL);
+	IgnoreRules *rules;
+	const gchar *name;
+
+	if (dir == NULL)
+	{
+		g_free(full_path);
+		return;
+	}
+
+	rules = ignore_rules_read(parent_rules, path, full_path);
+	while ((name = g_dir_read_name(dir)) != NULL && ! g_atomic_int_get(&search->cancelled))
+	{
+		gchar *child_path = *path ? g_strconcat(path, "/", name, NULL) : g_strdup(name);
+		gchar *child_full_path = g_build_filename(full_path, name, NULL);
+		GStatBuf st;
+
+		/* symbolic links are not followed, like grep -r does */
+		if (g_lstat(child_full_path, &st) == 0)
+		{
+			if (S_ISDIR(st.st_mode))
+			{
+				if (search->options.recursive && strcmp(name, ".git") != 0 &&
+					! is_ignored(rules, child_path, name, TRUE))
+				{
+					push_job(search, child_path, TRUE, rules);
+					child_path = NULL;
+				}
+			}
+			else if (S_ISREG(st.st_mode) && match_file_patterns(search, name) &&
+				! is_ignored(rules, child_path, name, FALSE))
+			{
+				push_job(search, child_path, FALSE, NULL);
+				child_path = NULL;
+			}
+		}
+		g_free(child_path);
+		g_free(child_full_path);
+	}
+	ignore_rules_unref(rules);
+	g_dir_close(dir);
+	g_free(full_path);
+}
+
+
+static void count_lines(LineCounter *counter, const gchar *pos)
+{
+	const gchar *nl;
+
+	while ((nl = memchr(counter->pos, '\n', pos - counter->pos)) != NULL)
+	{
+		counter->line++;
+		counter->line_start = nl + 1;
+		counter->pos = nl + 1;
+	}
+	counter->pos = pos;
+}
+
+
+static void add_match(FifSearch *search, GArray **matches, guint line,
+		const gchar *line_start, const gchar *line_end, gint column, gint length)
+{
+	FifMatch match;
+	gsize len = line_end - line_start;
+	gchar *text = NULL;
+
+	if (len > 0 && line_start[len - 1] == '\r')
+		len--;
+	len = MIN(len, MAX_LINE_LENGTH);
+
+	/* if the line is valid UTF-8, assume it is UTF-8 whatever the encoding is */
+	if (search->encoding != NULL && ! g_utf8_validate(line_start, len, NULL))
+		text = g_convert(line_start, len, "UTF-8", search->encoding, NULL, NULL, NULL);
+	if (text == NULL)
+		text = g_utf8_make_valid(line_start, len);
+
+	if (*matches == NULL)
+		*matches = g_array_new(FALSE, FALSE, sizeof(FifMatch));
+
+	match.file = NULL;
+	match.line = line;
+	match.column = column;
+	match.length = length;
+	match.text = text;
+	g_array_append_val(*matches, match);
+}
+
+
+/* Returns the next position in [pos, end) where the literal text starts, or NULL.
+ * Case insensitive comparison only folds ASCII letters, like GRegex in raw mode does. */
+static const gchar *find_literal(FifSearch *search, const gchar *pos, const gchar *end)
+{
+	const gchar *literal = search->literal;
+	gsize len = search->literal_len;
+	gchar first = literal[0];
+	gchar other = first;
+
+	if (! search->options.case_sensitive)
+		other = g_ascii_isupper(first) ? g_ascii_tolower(first) : g_ascii_toupper(first);
+
+	while ((gsize) (end - pos) >= len)
+	{
+		const gchar *limit = end - len + 1;
+		const gchar *p = memchr(pos, first, limit - pos);
+
+		if (other != first)
+		{
+			const gchar *q = memchr(pos, other, (p != NULL ? p : limit) - pos);
+
+			if (q != NULL)
+				p = q;
+		}
+		if (p == NULL)
+			return NULL;
+
+		if (search->options.case_sensitive ? memcmp(p, literal, len) == 0 :
+			g_ascii_strncasecmp(p, literal, len) == 0)
+			return p;
+		pos = p + 1;
+	}
+	return NULL;
+}
+
+
+/* Matches the regex in [start, line_end) of buf */
+static gboolean match_line(FifSearch *search, const gchar *buf, const gchar *start,
+		const gchar *line_end, gint *match_start, gint *match_end)
+{
+	GMatchInfo *info;
+	gboolean found;
+
+	/* buf is passed as a whole so lookbehinds see the text before start */
+	found = g_regex_match_full(search->regex, buf, line_end - buf, start - buf, 0, &info, NULL);
+	if (found)
+		g_match_info_fetch_pos(info, 0, match_start, match_end);
+	g_match_info_free(info);
+	return found;
+}
+
+
+static GArray *search_inverted(FifSearch *search, const gchar *buf, gsize len)
+{
+	const gchar *end = buf + len;
+	const gchar *pos = buf;
+	GArray *matches = NULL;
+	guint line = 1;
+
+	while (pos < end && ! g_atomic_int_get(&search->cancelled))
+	{
+		const gchar *line_end = memchr(pos, '\n', end - pos);
+
+		if (line_end == NULL)
+			line_end = end;
+		if (! g_regex_match_full(search->regex, buf, line_end - buf, pos - buf, 0, NULL, NULL))
+			add_match(search, &matches, line, pos, line_end, 0, 0);
+		line++;
+		pos = line_end + 1;
+	}
+	return matches;
+}
+
+
+/* Returns the matching lines of buf, at most one match per line like grep, or NULL */
+static GArray *search_buffer(FifSearch *search, const gchar *buf, gsize len)
+{
+	const gchar *end = buf + len;
+	const gchar *pos = buf;
+	LineCounter counter = { buf, buf, 1 };
+	GArray *matches = NULL;
+
+	if (memchr(buf, 0, MIN(len, BINARY_CHECK_SIZE)) != NULL)
+		return NULL;
+
+	if (search->options.invert)
+		return search_inverted(search, buf, len);
+
+	while (pos < end && ! g_atomic_int_get(&search->cancelled))
+	{
+		const gchar *start;
+		const gchar *line_end;
+		gint match_start = 0, match_end = 0;
+		gboolean found = TRUE;
+
+		if (search->literal != NULL)
+		{
+			start = find_literal(search, pos, end);
+			if (start == NULL)
+				break;
+		}
+		else
+		{
+			if (! match_line(search, buf, pos, end, &match_start, &match_end))
+				break;
+			start = buf + match_start;
+		}
+
+		count_lines(&counter, start);
+		line_end = memchr(start, '\n', end - start);
+		if (line_end == NULL)
+			line_end = end;
+
+		/* verify the candidates of the literal search (whole word, case) and restrict
+		 * matches spanning lines to their first line */
+		if (search->literal != NULL || buf + match_end > line_end)
+			found = match_line(search, buf, start, line_end, &match_start, &match_end);
+
+		if (found)
+		{
+			add_match(search, &matches, counter.line, counter.line_start, line_end,
+				match_start - (counter.line_start - buf), match_end - match_start);
+		}
+		pos = line_end + 1;
+	}
+	return matches;
+}
+
+
+static void search_file(FifSearch *search, const gchar *path)
+{
+	gchar *full_path = g_build_filename(search->dir, path, NULL);
+	GMappedFile *file = g_mapped_file_new(full_path, FALSE, NULL);
+	FileResults *results;
+	GArray *matches = NULL;
+	guint i;
+
+	g_free(full_path);
+	if (file == NULL)
+		return;
+
+	if (g_mapped_file_get_length(file) > 0)
+	{
+		matches = search_buffer(search, g_mapped_file_get_contents(file),
+			g_mapped_file_get_length(file));
+	}
+	g_mapped_file_unref(file);
+	if (matches == NULL)
+		return;
+
+	results = g_new(FileResults, 1);
+	results->file = utils_get_utf8_from_locale(path);
+	results->matches = matches;
+	for (i = 0; i < matches->len; i++)
+		g_array_index(matches, FifMatch, i).file = results->file;
+
+	g_mutex_lock(&search->lock);
+	g_ptr_array_add(search->results, results);
+	g_mutex_unlock(&search->lock);
+}
+
+
+static void run_job(gpointer data, gpointer user_data)
+{
+	FifJob *job = data;
+	FifSearch *search = user_data;
+
+	if (! g_atomic_int_get(&search->cancelled))
+	{
+		if (job->is_dir)
+			search_dir(search, job->path, job->rules);
+		else
+			search_file(search, job->path);
+	}
+	ignore_rules_unref(job->rules);
+	g_free(job->path);
+	g_free(job);
+
+	/* the search may be freed from now on */
+	g_atomic_int_dec_and_test(&search->pending);
+}
+
+
+/* Must only be called when no jobs are pending anymore */
+static void search_free(FifSearch *search)
+{
+	/* all jobs are done, this only waits for the threads to return from them */
+	g_thread_pool_free(search->pool, FALSE, TRUE);
+
+	searches = g_list_remove(searches, search);
+	if (current_search == search)
+		current_search = NULL;
+	if (search->flush_id != 0)
+		g_source_remove(search->flush_id);
+
+	if (search->file_patterns != NULL)
+		g_ptr_array_free(search->file_patterns, TRUE);
+	g_ptr_array_free(search->results, TRUE);
+	if (search->delivering != NULL)
+		g_ptr_array_free(search->delivering, TRUE);
+	g_mutex_clear(&search->lock);
+	g_regex_unref(search->regex);
+	g_free(search->literal);
+	g_free(search->encoding);
+	g_free(search->dir);
+	g_free(search);
+}
+
+
+static void take_results(FifSearch *search)
+{
+	if (search->delivering != NULL)
+		g_ptr_array_free(search->delivering, TRUE);
+
+	g_mutex_lock(&search->lock);
+	search->delivering = search->results;
+	search->results = g_ptr_array_new_with_free_func(file_results_free);
+	g_mutex_unlock(&search->lock);
+
+	search->delivered_files = 0;
+	search->delivered_matches = 0;
+}
+
+
+static gboolean flush_results(gpointer data)
+{
+	FifSearch *search = data;
+	guint budget = FLUSH_BATCH_SIZE;
+	gboolean done;
+
+	if (main_status.quitting)
+		g_atomic_int_set(&search->cancelled, TRUE);
+
+	/* read before taking the results, so the results of all jobs are taken when done */
+	done = g_atomic_int_get(&search->pending) == 0;
+
+	if (g_atomic_int_get(&search->cancelled))
+	{
+		if (! done)
+			return G_SOURCE_CONTINUE;
+
+		search->flush_id = 0;
+		search_free(search);
+		return G_SOURCE_REMOVE;
+	}
+
+	while (budget > 0)
+	{
+		FileResults *results;
+		guint n;
+
+		if (search->delivering == NULL || search->delivered_files == search->delivering->len)
+		{
+			take_results(search);
+			if (search->delivering->len == 0)
+				break;
+		}
+
+		results = search->delivering->pdata[search->delivered_files];
+		n = MIN(budget, results->matches->len - search->delivered_matches);
+		search->matches_cb(&g_array_index(results->matches, FifMatch, search->delivered_matches),
+			n, search->user_data);
+
+		search->n_matches += n;
+		search->delivered_matches += n;
+		budget -= n;
+		if (search->delivered_matches == results->matches->len)
+		{
+			search->delivered_files++;
+			search->delivered_matches = 0;
+		}
+	}
+
+	if (done && budget > 0)
+	{
+		search->flush_id = 0;
+		search->finished_cb(search->n_matches, search->user_data);
+		search_free(search);
+		return G_SOURCE_REMOVE;
+	}
+	return G_SOURCE_CONTINUE;
+}
+
+
+static GRegex *compile_regex(const gchar *text, const FifOptions *options, GError **error)
+{
+	/* raw mode as the files are not necessarily UTF-8 */
+	GRegexCompileFlags flags = G_REGEX_RAW | G_REGEX_MULTILINE | G_REGEX_OPTIMIZE;
+	GRegex *regex;
+	gchar *pattern;
+
+	if (! options->case_sensitive)
+		flags |= G_REGEX_CASELESS;
+
+	if (options->regexp)
+		pattern = g_strdup(text);
+	else
+		pattern = g_regex_escape_string(text, -1);
+
+	/* like grep -w, the match must neither be preceded nor followed by a word character */
+	if (options->whole_word)
+		SETPTR(pattern, g_strconcat("(?<!\\w)(?:", pattern, ")(?!\\w)", NULL));
+
+	regex = g_regex_new(pattern, flags, 0, error);
+	g_free(pattern);
+	return regex;
+}
+
+
+/* Starts searching the files in locale_dir, cancelling the previous search.
+ * matches_cb is called with the matching lines as they are found and finished_cb
+ * once all files are searched, unless the search is cancelled.
+ * Returns FALSE and sets error if the search text is not a valid regex. */
+gboolean fif_search_start(const gchar *utf8_text, const gchar *locale_dir, const FifOptions *options,
+		FifMatchesFunc matches_cb, FifFinishedFunc finished_cb, gpointer user_data, GError **error)
+{
+	FifSearch *search;
+	GRegex *regex;
+	gchar *text = NULL;
+
+	g_return_val_if_fail(! EMPTY(utf8_text), FALSE);
+	g_return_val_if_fail(locale_dir != NULL, FALSE);
+
+	/* convert the search text in the encoding of the files (if the text is not valid UTF-8,
+	 * assume it is already in that encoding) */
+	if (options->encoding != NULL && g_utf8_validate(utf8_text, -1, NULL))
+		text = g_convert(utf8_text, -1, options->encoding, "UTF-8", NULL, NULL, NULL);
+	if (text == NULL)
+		text = g_strdup(utf8_text);
+
+	regex = compile_regex(text, options, error);
+	if (regex == NULL)
+	{
+		g_free(text);
+		return FALSE;
+	}
+
+	fif_search_cancel();
+
+	search = g_new0(FifSearch, 1);
+	search->dir = g_strdup(locale_dir);
+	search->encoding = g_strdup(options->encoding);
+	search->options = *options;
+	search->options.file_patterns = NULL;
+	search->options.encoding = search->encoding;
+	search->regex = regex;
+	if (! options->regexp && ! options->invert)
+	{
+		search->literal = text;
+		search->literal_len = strlen(text);
+	}
+	else
+		g_free(text);
+
+	if (options->file_patterns != NULL)
+	{
+		gchar **pattern;
+
+		foreach_strv(pattern, options->file_patterns)
+		{
+			if (**pattern == 0)
+				continue;
+			if (search->file_patterns == NULL)
+				search->file_patterns = g_ptr_array_new_with_free_func((GDestroyNotify) g_pattern_spec_free);
+			g_ptr_array_add(search->file_patterns, g_pattern_spec_new(*pattern));
+		}
+	}
+
+	g_mutex_init(&search->lock);
+	search->results = g_ptr_array_new_with_free_func(file_results_free);
+	search->matches_cb = matches_cb;
+	search->finished_cb = finished_cb;
+	search->user_data = user_data;
+
+	/* the jobs are distributed over the threads by the shared pool queue */
+	search->pool = g_thread_pool_new(run_job, search, (gint) g_get_num_processors(), FALSE, NULL);
+	push_job(search, g_strdup(""), TRUE, NULL);
+	search->flush_id = g_timeout_add(FLUSH_INTERVAL, flush_results, search);
+
+	searches = g_list_prepend(searches, search);
+	current_search = search;
+	return TRUE;
+}
+
+
+/* Cancels the current search, its callbacks are not called anymore. */
+void fif_search_cancel(void)
+{
+	if (current_search != NULL)
+	{
+		g_atomic_int_set(&current_search->cancelled, TRUE);
+		current_search = NULL;
+	}
+}
+
+
+void fif_finalize(void)
+{
+	while (searches != NULL)
+	{
+		FifSearch *search = searches->data;
+
+		g_atomic_int_set(&search->cancelled, TRUE);
+		/* cancelled jobs return quickly */
+		while (g_atomic_int_get(&search->pending) > 0)
+			g_usleep(1000);
+		search_free(search);
+	}
+}
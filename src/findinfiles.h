@@ -0,0 +1,64 @@
+/*
+ *      findinfiles.h - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef GEANY_FINDINFILES_H
+#define GEANY_FINDINFILES_H 1
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct FifOptions
+{
+	gboolean regexp;
+	gboolean case_sensitive;
+	gboolean whole_word;
+	gboolean invert;
+	gboolean recursive;
+	gchar **file_patterns;	/* patterns the file names must match, NULL for all files */
+	const gchar *encoding;	/* encoding of the files, NULL for UTF-8 */
+}
+FifOptions;
+
+typedef struct FifMatch
+{
+	const gchar *file;	/* UTF-8, relative to the searched directory */
+	guint line;			/* 1-based */
+	guint column;		/* byte offset of the match in the line, 0 for inverted results */
+	guint length;		/* byte length of the match, 0 for inverted results */
+	const gchar *text;	/* UTF-8 text of the line */
+}
+FifMatch;
+
+typedef void (*FifMatchesFunc)(const FifMatch *matches, guint n_matches, gpointer user_data);
+
+typedef void (*FifFinishedFunc)(guint n_matches, gpointer user_data);
+
+gboolean fif_search_start(const gchar *utf8_text, const gchar *locale_dir, const FifOptions *options,
+		FifMatchesFunc matches_cb, FifFinishedFunc finished_cb, gpointer user_data, GError **error);
+
+void fif_search_cancel(void);
+
+void fif_finalize(void);
+
+G_END_DECLS
+
+#endif /* GEANY_FINDINFILES_H */
@@ -41,6 +41,7 @@ G_BEGIN_DECLS
 #define GEANY_FILEDEFS_SUBDIR			"filedefs"
 #define GEANY_TEMPLATES_SUBDIR			"templates"
 #define GEANY_TAGS_SUBDIR				"tags"
+#define GEANY_TAGS_CACHE_SUBDIR			"tags_cache"
 #define GEANY_CODENAME					"Coy"
 #define GEANY_HOMEPAGE					"https://www.geany.org/"
 #define GEANY_WIKI						"https://wiki.geany.org/"
@@ -0,0 +1,382 @@
+/*
+ *      geanymessagestore.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * An append-only list model for the Compiler and Messages tabs of the message window.
+ * Unlike GtkListStore, which keeps a GSequence node and a GValue per column for each
+ * row, the rows are kept in a single array of small structs and their strings in a
+ * GStringChunk, so very long lists only cost a few bytes per row besides the text.
+ * The values are only created when a view asks for them, i.e. for the visible rows
+ * when the view uses the fixed height mode.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "geanymessagestore.h"
+
+
+/* size of the blocks of the string chunk */
+#define STRING_CHUNK_SIZE 65536
+
+
+typedef struct
+{
+	const GdkColor *color;
+	const gchar *string;	/* in strings */
+	gint line;
+	guint doc_id;
+}
+MessageRow;
+
+struct _GeanyMessageStoreClass
+{
+	GObjectClass parent_class;
+};
+
+struct _GeanyMessageStore
+{
+	GObject parent;
+
+	GArray *rows;	/* MessageRow */
+	GStringChunk *strings;
+	gint stamp;
+	gint longest_row;	/* row with the longest string, -1 if empty */
+	gsize longest_length;
+};
+
+
+static void geany_message_store_tree_model_init(GtkTreeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(GeanyMessageStore, geany_message_store, G_TYPE_OBJECT,
+	G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_MODEL, geany_message_store_tree_model_init))
+
+
+static void geany_message_store_finalize(GObject *object)
+{
+	GeanyMessageStore *store = GEANY_MESSAGE_STORE(object);
+
+	g_array_free(store->rows, TRUE);
+	g_string_chunk_free(store->strings);
+
+	G_OBJECT_CLASS(geany_message_store_parent_class)->finalize(object);
+}
+
+
+static void geany_message_store_class_init(GeanyMessageStoreClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+	object_class->finalize = geany_message_store_finalize;
+}
+
+
+static void geany_message_store_init(GeanyMessageStore *store)
+{
+	store->rows = g_array_new(FALSE, FALSE, sizeof(MessageRow));
+	store->strings = g_string_chunk_new(STRING_CHUNK_SIZE);
+	store->stamp = g_random_int();
+	store->longest_row = -1;
+	store->longest_length = 0;
+}
+
+
+static gboolean iter_is_valid(GeanyMessageStore *store, GtkTreeIter *iter)
+{
+	return iter != NULL && iter->stamp == store->stamp &&
+		GPOINTER_TO_UINT(iter->user_data) < store->rows->len;
+}
+
+
+static void set_iter(GeanyMessageStore *store, GtkTreeIter *iter, guint row)
+{
+	iter->stamp = store->stamp;
+	iter->user_data = GUINT_TO_POINTER(row);
+	iter->user_data2 = NULL;
+	iter->user_data3 = NULL;
+}
+
+
+static GtkTreeModelFlags geany_message_store_get_flags(GtkTreeModel *model)
+{
+	return GTK_TREE_MODEL_LIST_ONLY | GTK_TREE_MODEL_ITERS_PERSIST;
+}
+
+
+static gint geany_message_store_get_n_columns(GtkTreeModel *model)
+{
+	return GEANY_MESSAGE_STORE_N_COLUMNS;
+}
+
+
+static GType geany_message_store_get_column_type(GtkTreeModel *model, gint column)
+{
+	switch (column)
+	{
+		case GEANY_MESSAGE_STORE_COL_LINE: return G_TYPE_INT;
+		case GEANY_MESSAGE_STORE_COL_DOC_ID: return G_TYPE_UINT;
+		case GEANY_MESSAGE_STORE_COL_COLOR: return GDK_TYPE_COLOR;
+		case GEANY_MESSAGE_STORE_COL_STRING: return G_TYPE_STRING;
+	}
+	g_return_val_if_reached(G_TYPE_INVALID);
+}
+
+
+static gboolean geany_message_store_get_iter(GtkTreeModel *model, GtkTreeIter *iter,
+		GtkTreePath *path)
+{
+	GeanyMessageStore *store = GEANY_MESSAGE_STORE(model);
+	gint index;
+
+	if (gtk_tree_path_get_depth(path) != 1)
+		return FALSE;
+
+	index = gtk_tree_path_get_indices(path)[0];
+	if (index < 0 || (guint) index >= store->rows->len)
+		return FALSE;
+
+	set_iter(store, iter, index);
+	return TRUE;
+}
+
+
+static GtkTreePath *geany_message_store_get_path(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GeanyMessageStore *store = GEANY_MESSAGE_STORE(model);
+
+	g_return_val_if_fail(iter_is_valid(store, iter), NULL);
+
+	return gtk_tree_path_new_from_indices(GPOINTER_TO_UINT(iter->user_data), -1);
+}
+
+
+static void geany_message_store_get_value(GtkTreeModel *model, GtkTreeIter *iter,
+		gint column, GValue *value)
+{
+	GeanyMessageStore *store = GEANY_MESSAGE_STORE(model);
+	MessageRow *row;
+
+	g_return_if_fail(iter_is_valid(store, iter));
+
+	row = &g_array_index(store->rows, MessageRow, GPOINTER_TO_UINT(iter->user_data));
+	g_value_init(value, geany_message_store_get_column_type(model, column));
+	switch (column)
+	{
+		case GEANY_MESSAGE_STORE_COL_LINE:
+			g_value_set_int(value, row->line);
+			break;
+		case GEANY_MESSAGE_STORE_COL_DOC_ID:
+			g_value_set_uint(value, row->doc_id);
+			break;
+		case GEANY_MESSAGE_STORE_COL_COLOR:
+			g_value_set_boxed(value, row->color);
+			break;
+		case GEANY_MESSAGE_STORE_COL_STRING:
+			g_value_set_static_string(value, row->string);
+			break;
+	}
+}
+
+
+static gboolean geany_message_store_iter_next(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GeanyMessageStore *store = GEANY_MESSAGE_STORE(model);
+	guint row = GPOINTER_TO_UINT(iter->user_data) + 1;
+
+	if (iter->stamp != store->stamp || row >= store->rows->len)
+	{
+		iter->stamp = 0;
+		return FALSE;
+	}
+	iter->user_data = GUINT_TO_POINTER(row);
+	return TRUE;
+}
+
+
+static gboolean geany_message_store_iter_previous(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GeanyMessageStore *store = GEANY_MESSAGE_STORE(model);
+	guint row = GPOINTER_TO_UINT(iter->user_data);
+
+	if (iter->stamp != store->stamp || row == 0 || row > store->rows->len)
+	{
+		iter->stamp = 0;
+		return FALSE;
+	}
+	iter->user_data = GUINT_TO_POINTER(row - 1);
+	return TRUE;
+}
+
+
+static gboolean geany_message_store_iter_nth_child(GtkTreeModel *model, GtkTreeIter *iter,
+		GtkTreeIter *parent, gint n)
+{
+	GeanyMessageStore *store = GEANY_MESSAGE_STORE(model);
+
+	if (parent != NULL || n < 0 || (guint) n >= store->rows->len)
+	{
+		iter->stamp = 0;
+		return FALSE;
+	}
+	set_iter(store, iter, n);
+	return TRUE;
+}
+
+
+static gboolean geany_message_store_iter_children(GtkTreeModel *model, GtkTreeIter *iter,
+		GtkTreeIter *parent)
+{
+	return geany_message_store_iter_nth_child(model, iter, parent, 0);
+}
+
+
+static gboolean geany_message_store_iter_has_child(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	return FALSE;
+}
+
+
+static gint geany_message_store_iter_n_children(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GeanyMessageStore *store = GEANY_MESSAGE_STORE(model);
+
+	return iter == NULL ? (gint) store->rows->len : 0;
+}
+
+
+static gboolean geany_message_store_iter_parent(GtkTreeModel *model, GtkTreeIter *iter,
+		GtkTreeIter *child)
+{
+	iter->stamp = 0;
+	return FALSE;
+}
+
+
+static void geany_message_store_tree_model_init(GtkTreeModelIface *iface)
+{
+	iface->get_flags = geany_message_store_get_flags;
+	iface->get_n_columns = geany_message_store_get_n_columns;
+	iface->get_column_type = geany_message_store_get_column_type;
+	iface->get_iter = geany_message_store_get_iter;
+	iface->get_path = geany_message_store_get_path;
+	iface->get_value = geany_message_store_get_value;
+	iface->iter_next = geany_message_store_iter_next;
+	iface->iter_previous = geany_message_store_iter_previous;
+	iface->iter_children = geany_message_store_iter_children;
+	iface->iter_has_child = geany_message_store_iter_has_child;
+	iface->iter_n_children = geany_message_store_iter_n_children;
+	iface->iter_nth_child = geany_message_store_iter_nth_child;
+	iface->iter_parent = geany_message_store_iter_parent;
+}
+
+
+GeanyMessageStore *geany_message_store_new(void)
+{
+	return g_object_new(GEANY_MESSAGE_STORE_TYPE, NULL);
+}
+
+
+/* Appends rows at once, the views are notified of each row as GtkTreeModel requires,
+ * but the caller only has to do its per-update work (e.g. scrolling) once. */
+void geany_message_store_append_rows(GeanyMessageStore *store, const GeanyMessageRow *rows,
+		guint n_rows)
+{
+	GtkTreePath *path;
+	GtkTreeIter iter;
+	guint i;
+
+	g_return_if_fail(IS_GEANY_MESSAGE_STORE(store));
+
+	if (n_rows == 0)
+		return;
+
+	path = gtk_tree_path_new_from_indices(store->rows->len, -1);
+	for (i = 0; i < n_rows; i++)
+	{
+		MessageRow row;
+
+		row.color = rows[i].color;
+		row.string = g_string_chunk_insert_len(store->strings, rows[i].string, rows[i].length);
+		row.line = rows[i].line;
+		row.doc_id = rows[i].doc_id;
+		g_array_append_val(store->rows, row);
+
+		if (store->longest_row < 0 || rows[i].length > store->longest_length)
+		{
+			store->longest_row = store->rows->len - 1;
+			store->longest_length = rows[i].length;
+		}
+
+		set_iter(store, &iter, store->rows->len - 1);
+		gtk_tree_model_row_inserted(GTK_TREE_MODEL(store), path, &iter);
+		gtk_tree_path_next(path);
+	}
+	gtk_tree_path_free(path);
+}
+
+
+/* Removing the rows of a store with many rows is faster when it is not set to a view. */
+void geany_message_store_clear(GeanyMessageStore *store)
+{
+	g_return_if_fail(IS_GEANY_MESSAGE_STORE(store));
+
+	while (store->rows->len > 0)
+	{
+		GtkTreePath *path;
+
+		g_array_set_size(store->rows, store->rows->len - 1);
+		path = gtk_tree_path_new_from_indices(store->rows->len, -1);
+		gtk_tree_model_row_deleted(GTK_TREE_MODEL(store), path);
+		gtk_tree_path_free(path);
+	}
+	g_string_chunk_clear(store->strings);
+	store->longest_row = -1;
+	store->longest_length = 0;
+	/* invalidate the iters */
+	store->stamp++;
+}
+
+
+guint geany_message_store_get_n_rows(GeanyMessageStore *store)
+{
+	g_return_val_if_fail(IS_GEANY_MESSAGE_STORE(store), 0);
+
+	return store->rows->len;
+}
+
+
+/* Returns the row with the longest string in bytes, or -1 if the store is empty */
+gint geany_message_store_get_longest_row(GeanyMessageStore *store)
+{
+	g_return_val_if_fail(IS_GEANY_MESSAGE_STORE(store), -1);
+
+	return store->longest_row;
+}
+
+
+/* Returns the string of row, owned by the store */
+const gchar *geany_message_store_get_string(GeanyMessageStore *store, guint row)
+{
+	g_return_val_if_fail(IS_GEANY_MESSAGE_STORE(store), NULL);
+	g_return_val_if_fail(row < store->rows->len, NULL);
+
+	return g_array_index(store->rows, MessageRow, row).string;
+}
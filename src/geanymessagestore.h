@@ -0,0 +1,76 @@
+/*
+ *      geanymessagestore.h - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef GEANY_MESSAGE_STORE_H
+#define GEANY_MESSAGE_STORE_H 1
+
+#include "gtkcompat.h"
+
+G_BEGIN_DECLS
+
+
+#define GEANY_MESSAGE_STORE_TYPE			(geany_message_store_get_type())
+#define GEANY_MESSAGE_STORE(obj)			(G_TYPE_CHECK_INSTANCE_CAST((obj), \
+	GEANY_MESSAGE_STORE_TYPE, GeanyMessageStore))
+#define GEANY_MESSAGE_STORE_CLASS(klass)	(G_TYPE_CHECK_CLASS_CAST((klass), \
+	GEANY_MESSAGE_STORE_TYPE, GeanyMessageStoreClass))
+#define IS_GEANY_MESSAGE_STORE(obj)			(G_TYPE_CHECK_INSTANCE_TYPE((obj), \
+	GEANY_MESSAGE_STORE_TYPE))
+#define IS_GEANY_MESSAGE_STORE_CLASS(klass)	(G_TYPE_CHECK_CLASS_TYPE((klass), \
+	GEANY_MESSAGE_STORE_TYPE))
+
+
+/* the columns of the store */
+enum
+{
+	GEANY_MESSAGE_STORE_COL_LINE = 0,	/* gint */
+	GEANY_MESSAGE_STORE_COL_DOC_ID,		/* guint */
+	GEANY_MESSAGE_STORE_COL_COLOR,		/* GdkColor */
+	GEANY_MESSAGE_STORE_COL_STRING,		/* gchar* */
+	GEANY_MESSAGE_STORE_N_COLUMNS
+};
+
+/* A row to append, the string is copied */
+typedef struct GeanyMessageRow
+{
+	const GdkColor *color;	/* must stay valid as long as the row, NULL for the default color */
+	gint line;
+	guint doc_id;
+	const gchar *string;	/* UTF-8 */
+	gsize length;			/* length of string in bytes */
+}
+GeanyMessageRow;
+
+typedef struct _GeanyMessageStore       GeanyMessageStore;
+typedef struct _GeanyMessageStoreClass  GeanyMessageStoreClass;
+
+GType				geany_message_store_get_type		(void);
+GeanyMessageStore*	geany_message_store_new				(void);
+void				geany_message_store_append_rows		(GeanyMessageStore *store,
+														 const GeanyMessageRow *rows, guint n_rows);
+void				geany_message_store_clear			(GeanyMessageStore *store);
+guint				geany_message_store_get_n_rows		(GeanyMessageStore *store);
+gint				geany_message_store_get_longest_row	(GeanyMessageStore *store);
+const gchar*		geany_message_store_get_string		(GeanyMessageStore *store, guint row);
+
+
+G_END_DECLS
+
+#endif /* GEANY_MESSAGE_STORE_H */
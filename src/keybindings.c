@@ -588,6 +588,8 @@ static void init_default_kb(void)
 	add_kb(group, GEANY_KEYS_GOTO_TAGDECLARATION, NULL,
 		GDK_KEY_t, GEANY_PRIMARY_MOD_MASK | GDK_SHIFT_MASK, "popup_gototagdeclaration",
 		_("Go to Symbol Declaration"), "goto_tag_declaration1");
+	add_kb(group, GEANY_KEYS_GOTO_SYMBOL, NULL,
+		0, 0, "edit_gotosymbol", _("Go to Symbol"), "go_to_symbol1");
 	add_kb(group, GEANY_KEYS_GOTO_LINESTART, NULL,
 		GDK_KEY_Home, 0, "edit_gotolinestart", _("Go to Start of Line"), NULL);
 	add_kb(group, GEANY_KEYS_GOTO_LINEEND, NULL,
@@ -2030,6 +2032,9 @@ static gboolean cb_func_goto_action(guint key_id)
 		case GEANY_KEYS_GOTO_FORWARD:
 			navqueue_go_forward();
 			return TRUE;
+		case GEANY_KEYS_GOTO_SYMBOL:
+			symbols_show_goto_symbol_dialog();
+			return TRUE;
 		case GEANY_KEYS_GOTO_LINE:
 		{
 			if (toolbar_prefs.visible)
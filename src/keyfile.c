@@ -318,6 +318,18 @@ static void init_pref_groups(void)
 		"indent_hard_tab_width", 8);
 	stash_group_add_integer(group, &editor_prefs.ime_interaction,
 		"editor_ime_interaction", SC_IME_WINDOWED);
+	stash_group_add_integer(group, &editor_prefs.symbol_parse_workers,
+		"symbol_parse_workers", 1);
+	stash_group_add_integer(group, &editor_prefs.symbol_cache_size,
+		"symbol_cache_size", 64);
+	stash_group_add_integer(group, &editor_prefs.symbol_parse_time_limit,
+		"symbol_parse_time_limit", 2000);
+	stash_group_add_boolean(group, &editor_prefs.autocompletion_fuzzy,
+		"autocompletion_fuzzy", FALSE);
+	stash_group_add_integer(group, &editor_prefs.autocompletion_include_depth,
+		"autocompletion_include_depth", 2);
+	stash_group_add_integer(group, &editor_prefs.project_index_max_files,
+		"project_index_max_files", 5000);
 
 	group = stash_group_new(PACKAGE);
 	configuration_add_various_pref_group(group, "files");
@@ -350,6 +362,8 @@ static void init_pref_groups(void)
 		"replace_and_find_by_default", TRUE);
 	stash_group_add_boolean(group, &search_prefs.skip_confirmation_for_replace_in_session,
 		"skip_confirmation_for_replace_in_session", FALSE);
+	stash_group_add_boolean(group, &search_prefs.fif_use_grep,
+		"fif_use_grep", FALSE);
 
 	group = stash_group_new(PACKAGE);
 	configuration_add_various_pref_group(group, "socket");
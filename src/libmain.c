@@ -108,6 +108,8 @@ static gchar *lib_vte = NULL;
 #endif
 static gboolean generate_tags = FALSE;
 static gboolean no_preprocessing = FALSE;
+static gboolean binary_tags = FALSE;
+static gint tags_jobs = 1;
 static gboolean ft_names = FALSE;
 static gboolean print_prefix = FALSE;
 #ifdef HAVE_PLUGINS
@@ -123,6 +125,8 @@ static GOptionEntry entries[] =
 	{ "ft-names", 0, 0, G_OPTION_ARG_NONE, &ft_names, N_("Print internal filetype names"), NULL },
 	{ "generate-tags", 'g', 0, G_OPTION_ARG_NONE, &generate_tags, N_("Generate global tags file (see documentation)"), NULL },
 	{ "no-preprocessing", 'P', 0, G_OPTION_ARG_NONE, &no_preprocessing, N_("Don't preprocess C/C++ files when generating tags file"), NULL },
+	{ "binary-tags", 0, 0, G_OPTION_ARG_NONE, &binary_tags, N_("Write the generated tags file in the binary format"), NULL },
+	{ "tags-jobs", 0, 0, G_OPTION_ARG_INT, &tags_jobs, N_("Parse the files for the generated tags file in N processes"), N_("N") },
 #ifdef HAVE_SOCKET
 	{ "new-instance", 'i', 0, G_OPTION_ARG_NONE, &cl_options.new_instance, N_("Don't open files in a running instance, force opening a new instance"), NULL },
 	{ "socket-file", 0, 0, G_OPTION_ARG_FILENAME, &cl_options.socket_filename, N_("Use socket filename FILE for communication with a running Geany instance"), N_("FILE") },
@@ -635,7 +639,8 @@ static void parse_command_line_options(gint *argc, gchar ***argv)
 		gboolean ret;
 
 		filetypes_init_types();
-		ret = symbols_generate_global_tags(*argc, *argv, ! no_preprocessing);
+		ret = symbols_generate_global_tags(*argc, *argv, ! no_preprocessing, binary_tags,
+			tags_jobs);
 		filetypes_free_types();
 		wait_for_input_on_windows();
 		exit(ret);
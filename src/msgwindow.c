@@ -36,6 +36,7 @@
 #include "document.h"
 #include "callbacks.h"
 #include "filetypes.h"
+#include "geanymessagestore.h"
 #include "keybindings.h"
 #include "main.h"
 #include "navqueue.h"
@@ -67,25 +68,32 @@ MessageWindow msgwindow;
 
 enum
 {
-	MSG_COL_LINE = 0,
-	MSG_COL_DOC_ID,
-	MSG_COL_COLOR,
-	MSG_COL_STRING,
-	MSG_COL_COUNT
+	MSG_COL_LINE = GEANY_MESSAGE_STORE_COL_LINE,
+	MSG_COL_DOC_ID = GEANY_MESSAGE_STORE_COL_DOC_ID,
+	MSG_COL_COLOR = GEANY_MESSAGE_STORE_COL_COLOR,
+	MSG_COL_STRING = GEANY_MESSAGE_STORE_COL_STRING
 };
 
 enum
 {
-	COMPILER_COL_COLOR = 0,
-	COMPILER_COL_STRING,
-	COMPILER_COL_COUNT
+	COMPILER_COL_COLOR = GEANY_MESSAGE_STORE_COL_COLOR,
+	COMPILER_COL_STRING = GEANY_MESSAGE_STORE_COL_STRING
 };
 
+/* work around a strange problem when adding very long lines (greater than 4000 bytes):
+ * the messages in the messages tab are cut to a maximum of 1024 bytes */
+/* TODO: find the real cause for the display problem / if it is GtkTreeView file a bug report */
+#define MSG_MAX_LENGTH 1024
+
 
 static GdkColor color_error = {0, 0xFFFF, 0, 0};
 static GdkColor color_context = {0, 0x7FFF, 0, 0};
 static GdkColor color_message = {0, 0, 0, 0xD000};
 
+/* the rows the column widths were last computed for, see update_column_width() */
+static gint msg_measured_row = -1;
+static gint compiler_measured_row = -1;
+
 
 static void prepare_msg_tree_view(void);
 static void prepare_status_tree_view(void);
@@ -217,6 +225,111 @@ static void prepare_status_tree_view(void)
 }
 
 
+/* The Messages and Compiler tabs use the fixed height mode so the tree views only
+ * measure the visible rows, which keeps them responsive with many rows. The width of
+ * the column is set to fit the longest message instead of being computed from all rows. */
+static void update_column_width(GtkWidget *tree, gint *measured_row)
+{
+	GtkTreeModel *model = gtk_tree_view_get_model(GTK_TREE_VIEW(tree));
+	GtkTreeViewColumn *column = gtk_tree_view_get_column(GTK_TREE_VIEW(tree), 0);
+	GtkCellRenderer *renderer;
+	PangoLayout *layout;
+	GList *cells;
+	gint row, width, xpad, separator;
+
+	if (model == NULL)
+		return;
+
+	row = geany_message_store_get_longest_row(GEANY_MESSAGE_STORE(model));
+	if (row == *measured_row)
+		return;
+	*measured_row = row;
+	if (row < 0)
+		return;
+
+	layout = gtk_widget_create_pango_layout(tree,
+		geany_message_store_get_string(GEANY_MESSAGE_STORE(model), row));
+	pango_layout_get_pixel_size(layout, &width, NULL);
+	g_object_unref(layout);
+
+	cells = gtk_cell_layout_get_cells(GTK_CELL_LAYOUT(column));
+	renderer = cells->data;
+	g_list_free(cells);
+	gtk_cell_renderer_get_padding(renderer, &xpad, NULL);
+	gtk_widget_style_get(tree, "horizontal-separator", &separator, NULL);
+
+	width += 2 * xpad + separator;
+	if (width > gtk_tree_view_column_get_fixed_width(column))
+		gtk_tree_view_column_set_fixed_width(column, width);
+}
+
+
+static void on_msgwin_style_updated(GtkWidget *widget, gpointer data)
+{
+	gint *measured_row = data;
+
+	/* measure the longest row again with the new font */
+	*measured_row = -1;
+	gtk_tree_view_column_set_fixed_width(gtk_tree_view_get_column(GTK_TREE_VIEW(widget), 0), 1);
+	update_column_width(widget, measured_row);
+}
+
+
+static void set_column_fixed_sizing(GtkWidget *tree, GtkTreeViewColumn *column, gint *measured_row)
+{
+	gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width(column, 1);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(tree), column);
+	gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(tree), TRUE);
+
+	g_signal_connect(tree, "style-updated", G_CALLBACK(on_msgwin_style_updated), measured_row);
+}
+
+
+static void clear_message_store(GtkWidget *tree, GeanyMessageStore *store, gint *measured_row)
+{
+	/* notifying the view of each removed row is slow with many rows */
+	g_object_ref(store);
+	gtk_tree_view_set_model(GTK_TREE_VIEW(tree), NULL);
+	geany_message_store_clear(store);
+	gtk_tree_view_set_model(GTK_TREE_VIEW(tree), GTK_TREE_MODEL(store));
+	gtk_tree_view_set_search_column(GTK_TREE_VIEW(tree), GEANY_MESSAGE_STORE_COL_STRING);
+	g_object_unref(store);
+
+	/* reset the width after any long messages */
+	*measured_row = -1;
+	gtk_tree_view_column_set_fixed_width(gtk_tree_view_get_column(GTK_TREE_VIEW(tree), 0), 1);
+}
+
+
+/* Sets the string of row to the UTF-8 text of string, cut to max_length bytes.
+ * Returns the converted string to free if string was not valid UTF-8, or NULL. */
+static gchar *set_row_string(GeanyMessageRow *row, const gchar *string, gsize max_length)
+{
+	gchar *utf8 = NULL;
+	gsize len = strlen(string);
+
+	if (! g_utf8_validate(string, len, NULL))
+	{
+		utf8 = utils_get_utf8_from_locale(string);
+		if (! g_utf8_validate(utf8, -1, NULL))
+			SETPTR(utf8, g_utf8_make_valid(string, len));
+		string = utf8;
+		len = strlen(string);
+	}
+	if (len > max_length)
+	{
+		/* cut at a character boundary */
+		len = max_length;
+		while (len > 0 && (string[len] & 0xC0) == 0x80)
+			len--;
+	}
+	row->string = string;
+	row->length = len;
+	return utf8;
+}
+
+
 /* does some preparing things to the message list widget
  * (currently used for showing results of 'Find usage') */
 static void prepare_msg_tree_view(void)
@@ -225,16 +338,14 @@ static void prepare_msg_tree_view(void)
 	GtkTreeViewColumn *column;
 	GtkTreeSelection *selection;
 
-	/* line, doc id, fg, str */
-	msgwindow.store_msg = gtk_list_store_new(MSG_COL_COUNT, G_TYPE_INT, G_TYPE_UINT,
-		GDK_TYPE_COLOR, G_TYPE_STRING);
+	msgwindow.store_msg = geany_message_store_new();
 	gtk_tree_view_set_model(GTK_TREE_VIEW(msgwindow.tree_msg), GTK_TREE_MODEL(msgwindow.store_msg));
 	g_object_unref(msgwindow.store_msg);
 
 	renderer = gtk_cell_renderer_text_new();
 	column = gtk_tree_view_column_new_with_attributes(NULL, renderer,
 		"foreground-gdk", MSG_COL_COLOR, "text", MSG_COL_STRING, NULL);
-	gtk_tree_view_append_column(GTK_TREE_VIEW(msgwindow.tree_msg), column);
+	set_column_fixed_sizing(msgwindow.tree_msg, column, &msg_measured_row);
 
 	gtk_tree_view_set_search_column(GTK_TREE_VIEW(msgwindow.tree_msg), MSG_COL_STRING);
 
@@ -264,14 +375,14 @@ static void prepare_compiler_tree_view(void)
 	GtkTreeViewColumn *column;
 	GtkTreeSelection *selection;
 
-	msgwindow.store_compiler = gtk_list_store_new(COMPILER_COL_COUNT, GDK_TYPE_COLOR, G_TYPE_STRING);
+	msgwindow.store_compiler = geany_message_store_new();
 	gtk_tree_view_set_model(GTK_TREE_VIEW(msgwindow.tree_compiler), GTK_TREE_MODEL(msgwindow.store_compiler));
 	g_object_unref(msgwindow.store_compiler);
 
 	renderer = gtk_cell_renderer_text_new();
 	column = gtk_tree_view_column_new_with_attributes(NULL, renderer,
 		"foreground-gdk", COMPILER_COL_COLOR, "text", COMPILER_COL_STRING, NULL);
-	gtk_tree_view_append_column(GTK_TREE_VIEW(msgwindow.tree_compiler), column);
+	set_column_fixed_sizing(msgwindow.tree_compiler, column, &compiler_measured_row);
 
 	gtk_tree_view_set_search_column(GTK_TREE_VIEW(msgwindow.tree_compiler), COMPILER_COL_STRING);
 
@@ -342,30 +453,26 @@ void msgwin_compiler_add(gint msg_color, const gchar *format, ...)
 GEANY_API_SYMBOL
 void msgwin_compiler_add_string(gint msg_color, const gchar *msg)
 {
-	GtkTreeIter iter;
-	const GdkColor *color = get_color(msg_color);
+	GeanyMessageRow row;
 	gchar *utf8_msg;
 
-	if (! g_utf8_validate(msg, -1, NULL))
-		utf8_msg = utils_get_utf8_from_locale(msg);
-	else
-		utf8_msg = (gchar *) msg;
+	row.color = get_color(msg_color);
+	row.line = -1;
+	row.doc_id = 0;
+	utf8_msg = set_row_string(&row, msg, G_MAXSIZE);
+	geany_message_store_append_rows(msgwindow.store_compiler, &row, 1);
+	g_free(utf8_msg);
 
-	gtk_list_store_append(msgwindow.store_compiler, &iter);
-	gtk_list_store_set(msgwindow.store_compiler, &iter,
-		COMPILER_COL_COLOR, color, COMPILER_COL_STRING, utf8_msg, -1);
+	update_column_width(msgwindow.tree_compiler, &compiler_measured_row);
 
 	if (ui_prefs.msgwindow_visible && interface_prefs.compiler_tab_autoscroll)
 	{
-		GtkTreePath *path = gtk_tree_model_get_path(
-			gtk_tree_view_get_model(GTK_TREE_VIEW(msgwindow.tree_compiler)), &iter);
+		GtkTreePath *path = gtk_tree_path_new_from_indices(
+			geany_message_store_get_n_rows(msgwindow.store_compiler) - 1, -1);
 
 		gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(msgwindow.tree_compiler), path, NULL, TRUE, 0.5, 0.5);
 		gtk_tree_path_free(path);
 	}
-
-	if (utf8_msg != msg)
-		g_free(utf8_msg);
 }
 
 
@@ -450,37 +557,56 @@ void msgwin_msg_add(gint msg_color, gint line, GeanyDocument *doc, const gchar *
 GEANY_API_SYMBOL
 void msgwin_msg_add_string(gint msg_color, gint line, GeanyDocument *doc, const gchar *string)
 {
-	GtkTreeIter iter;
-	const GdkColor *color = get_color(msg_color);
-	gchar *tmp;
-	gsize len;
+	GeanyMessageRow row;
 	gchar *utf8_msg;
 
 	if (! ui_prefs.msgwindow_visible)
 		msgwin_show_hide(TRUE);
 
-	/* work around a strange problem when adding very long lines(greater than 4000 bytes)
-	 * cut the string to a maximum of 1024 bytes and discard the rest */
-	/* TODO: find the real cause for the display problem / if it is GtkTreeView file a bug report */
-	len = strlen(string);
-	if (len > 1024)
-		tmp = g_strndup(string, 1024);
-	else
-		tmp = g_strdup(string);
+	row.color = get_color(msg_color);
+	row.line = line;
+	row.doc_id = doc ? doc->id : 0;
+	utf8_msg = set_row_string(&row, string, MSG_MAX_LENGTH);
+	geany_message_store_append_rows(msgwindow.store_msg, &row, 1);
+	g_free(utf8_msg);
 
-	if (! g_utf8_validate(tmp, -1, NULL))
-		utf8_msg = utils_get_utf8_from_locale(tmp);
-	else
-		utf8_msg = tmp;
+	update_column_width(msgwindow.tree_msg, &msg_measured_row);
+}
 
-	gtk_list_store_append(msgwindow.store_msg, &iter);
-	gtk_list_store_set(msgwindow.store_msg, &iter,
-		MSG_COL_LINE, line, MSG_COL_DOC_ID, doc ? doc->id : 0, MSG_COL_COLOR,
-		color, MSG_COL_STRING, utf8_msg, -1);
 
-	g_free(tmp);
-	if (utf8_msg != tmp)
-		g_free(utf8_msg);
+/* Adds several messages without document and line to the messages tab at once,
+ * which is faster than adding them one by one */
+void msgwin_msg_add_strings(gint msg_color, const gchar * const *strings, guint n_strings)
+{
+	const GdkColor *color = get_color(msg_color);
+	GeanyMessageRow *rows;
+	GPtrArray *converted;
+	guint i;
+
+	if (n_strings == 0)
+		return;
+
+	if (! ui_prefs.msgwindow_visible)
+		msgwin_show_hide(TRUE);
+
+	rows = g_new(GeanyMessageRow, n_strings);
+	converted = g_ptr_array_new_with_free_func(g_free);
+	for (i = 0; i < n_strings; i++)
+	{
+		gchar *utf8_msg;
+
+		rows[i].color = color;
+		rows[i].line = -1;
+		rows[i].doc_id = 0;
+		utf8_msg = set_row_string(&rows[i], strings[i], MSG_MAX_LENGTH);
+		if (utf8_msg != NULL)
+			g_ptr_array_add(converted, utf8_msg);
+	}
+	geany_message_store_append_rows(msgwindow.store_msg, rows, n_strings);
+	g_ptr_array_free(converted, TRUE);
+	g_free(rows);
+
+	update_column_width(msgwindow.tree_msg, &msg_measured_row);
 }
 
 
@@ -602,7 +728,7 @@ on_compiler_treeview_copy_activate(GtkMenuItem *menuitem, gpointer user_data)
 
 static void on_compiler_treeview_copy_all_activate(GtkMenuItem *menuitem, gpointer user_data)
 {
-	GtkListStore *store = msgwindow.store_compiler;
+	GtkTreeModel *model = GTK_TREE_MODEL(msgwindow.store_compiler);
 	GtkTreeIter iter;
 	GString *str = g_string_new("");
 	gint str_idx = COMPILER_COL_STRING;
@@ -611,7 +737,7 @@ static void on_compiler_treeview_copy_all_activate(GtkMenuItem *menuitem, gpoint
 	switch (GPOINTER_TO_INT(user_data))
 	{
 		case MSG_STATUS:
-		store = msgwindow.store_status;
+		model = GTK_TREE_MODEL(msgwindow.store_status);
 		str_idx = 0;
 		break;
 
@@ -620,18 +746,18 @@ static void on_compiler_treeview_copy_all_activate(GtkMenuItem *menuitem, gpoint
 		break;
 
 		case MSG_MESSAGE:
-		store = msgwindow.store_msg;
+		model = GTK_TREE_MODEL(msgwindow.store_msg);
 		str_idx = MSG_COL_STRING;
 		break;
 	}
 
 	/* walk through the list and copy every line into a string */
-	valid = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(store), &iter);
+	valid = gtk_tree_model_get_iter_first(model, &iter);
 	while (valid)
 	{
 		gchar *line;
 
-		gtk_tree_model_get(GTK_TREE_MODEL(store), &iter, str_idx, &line, -1);
+		gtk_tree_model_get(model, &iter, str_idx, &line, -1);
 		if (!EMPTY(line))
 		{
 			g_string_append(str, line);
@@ -639,7 +765,7 @@ static void on_compiler_treeview_copy_all_activate(GtkMenuItem *menuitem, gpoint
 		}
 		g_free(line);
 
-		valid = gtk_tree_model_iter_next(GTK_TREE_MODEL(store), &iter);
+		valid = gtk_tree_model_iter_next(model, &iter);
 	}
 
 	/* copy the string into the clipboard */
@@ -1322,23 +1448,20 @@ void msgwin_switch_tab(gint tabnum, gboolean show)
 GEANY_API_SYMBOL
 void msgwin_clear_tab(gint tabnum)
 {
-	GtkListStore *store = NULL;
-
 	switch (tabnum)
 	{
 		case MSG_MESSAGE:
-			store = msgwindow.store_msg;
+			clear_message_store(msgwindow.tree_msg, msgwindow.store_msg, &msg_measured_row);
 			break;
 
 		case MSG_COMPILER:
-			gtk_list_store_clear(msgwindow.store_compiler);
+			clear_message_store(msgwindow.tree_compiler, msgwindow.store_compiler,
+				&compiler_measured_row);
 			build_menu_update(NULL);	/* update next error items */
-			return;
+			break;
 
-		case MSG_STATUS: store = msgwindow.store_status; break;
-		default: return;
+		case MSG_STATUS:
+			gtk_list_store_clear(msgwindow.store_status);
+			break;
 	}
-	if (store == NULL)
-		return;
-	gtk_list_store_clear(store);
 }
@@ -70,11 +70,13 @@ void msgwin_set_messages_dir(const gchar *messages_dir);
 
 #ifdef GEANY_PRIVATE
 
+struct _GeanyMessageStore;
+
 typedef struct
 {
 	GtkListStore	*store_status;
-	GtkListStore	*store_msg;
-	GtkListStore	*store_compiler;
+	struct _GeanyMessageStore	*store_msg;
+	struct _GeanyMessageStore	*store_compiler;
 	GtkWidget		*tree_compiler;
 	GtkWidget		*tree_status;
 	GtkWidget		*tree_msg;
@@ -107,6 +109,8 @@ void msgwin_parse_compiler_error_line(const gchar *string, const gchar *dir,
 
 gboolean msgwin_goto_messages_file_line(gboolean focus_editor);
 
+void msgwin_msg_add_strings(gint msg_color, const gchar * const *strings, guint n_strings);
+
 #endif /* GEANY_PRIVATE */
 
 G_END_DECLS
@@ -37,6 +37,7 @@
 #include "geanyobject.h"
 #include "keyfile.h"
 #include "main.h"
+#include "projectindex.h"
 #include "projectprivate.h"
 #include "sidebar.h"
 #include "stash.h"
@@ -484,6 +485,7 @@ static void destroy_project(gboolean open_default)
 	g_signal_emit_by_name(geany_object, "project-close");
 
 	update_ui();
+	project_index_update();
 }
 
 
@@ -882,6 +884,7 @@ static gboolean update_config(const PropertyDialogElements *e, gboolean new_proj
 	}
 
 	update_ui();
+	project_index_update();
 
 	return TRUE;
 }
@@ -1134,6 +1137,7 @@ static gboolean load_config(const gchar *filename)
 	g_key_file_free(config);
 
 	update_ui();
+	project_index_update();
 	return TRUE;
 }
 
@@ -1391,9 +1395,11 @@ const GeanyFilePrefs *project_get_file_prefs(void)
 
 void project_init(void)
 {
+	project_index_init();
 }
 
 
 void project_finalize(void)
 {
+	project_index_finalize();
 }
@@ -0,0 +1,595 @@
+/*
+ *      projectindex.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Background indexing of the files of the open project. The files below the
+ * project base path matching the project file patterns are added to the tag
+ * manager workspace in small batches from low priority idle callbacks, so their
+ * symbols are available to autocompletion, symbol navigation and Find Usage
+ * without opening them. Open documents are left to document.c and directory
+ * monitors keep the index up to date.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "projectindex.h"
+
+#include "app.h"
+#include "document.h"
+#include "editor.h"
+#include "filetypes.h"
+#include "geanyobject.h"
+#include "main.h"
+#include "project.h"
+#include "support.h"
+#include "tm_source_file.h"
+#include "tm_workspace.h"
+#include "ui_utils.h"
+#include "utils.h"
+
+#include <string.h>
+#include <gio/gio.h>
+
+
+/* number of files added to the workspace at once */
+#define INDEX_BATCH_SIZE 16
+/* time in microseconds after the last edit during which indexing pauses */
+#define INDEX_TYPING_PAUSE (G_USEC_PER_SEC)
+/* minimal time in microseconds between updates of the progress in the status bar */
+#define INDEX_STATUS_INTERVAL (G_USEC_PER_SEC)
+/* maximum number of monitored directories */
+#define INDEX_MAX_MONITORS 1024
+
+
+typedef struct
+{
+	gchar *base_path;  /* locale encoded */
+	gchar **patterns;  /* the file patterns of the project when the index was started */
+	GPtrArray *specs;  /* GPatternSpecs of patterns */
+	GQueue dirs;  /* directories still to be walked */
+	GQueue files;  /* files waiting to be added to the workspace */
+	GHashTable *queued;  /* the file names in files */
+	GHashTable *source_files;  /* real path -> TMSourceFile added by the index */
+	GHashTable *monitors;  /* directory -> GFileMonitor */
+	guint num_found;  /* number of files found, see project_index_max_files */
+	guint num_added;  /* number of files added during the current pass */
+	gboolean update_pending;  /* files were added without updating the workspace tags */
+	guint step_id;
+	gint64 status_time;
+}
+ProjectIndex;
+
+static ProjectIndex *project_index = NULL;
+static gint64 last_edit_time = 0;
+
+
+static void schedule_step(void);
+
+
+static gboolean is_index_candidate(const gchar *locale_filename, const gchar **lang_name)
+{
+	gchar *utf8_filename = utils_get_utf8_from_locale(locale_filename);
+	gchar *basename = g_path_get_basename(utf8_filename);
+	GeanyFiletype *ft;
+	gboolean ret = FALSE;
+
+	if (basename[0] != '.')
+	{
+		guint i;
+
+		ret = project_index->specs->len == 0;
+		for (i = 0; !ret && i < project_index->specs->len; i++)
+			ret = g_pattern_match_string(project_index->specs->pdata[i], basename);
+	}
+	if (ret)
+	{
+		ft = filetypes_detect_from_extension(utf8_filename);
+		ret = ft->id != GEANY_FILETYPES_NONE && filetype_has_tags(ft);
+		if (ret && lang_name)
+			*lang_name = tm_source_file_get_lang_name(ft->lang);
+	}
+
+	g_free(basename);
+	g_free(utf8_filename);
+	return ret;
+}
+
+
+/* Whether project_index_max_files files were found */
+static gboolean is_index_full(void)
+{
+	return project_index->num_found >= (guint) editor_prefs.project_index_max_files;
+}
+
+
+static void queue_file(const gchar *locale_filename)
+{
+	if (g_hash_table_contains(project_index->queued, locale_filename))
+		return;
+
+	if (!g_hash_table_contains(project_index->source_files, locale_filename))
+	{
+		if (is_index_full())
+			return;
+		project_index->num_found++;
+	}
+
+	g_queue_push_tail(&project_index->files, g_strdup(locale_filename));
+	g_hash_table_add(project_index->queued, project_index->files.tail->data);
+	schedule_step();
+}
+
+
+static void queue_dir(const gchar *locale_dir)
+{
+	/* no new files can be indexed, don't walk or monitor any more directories */
+	if (is_index_full())
+		return;
+
+	g_queue_push_tail(&project_index->dirs, g_strdup(locale_dir));
+	schedule_step();
+}
+
+
+static void remove_file(const gchar *locale_filename)
+{
+	TMSourceFile *source_file = g_hash_table_lookup(project_index->source_files, locale_filename);
+
+	if (source_file)
+	{
+		tm_workspace_remove_source_file(source_file);
+		g_hash_table_remove(project_index->source_files, locale_filename);
+		tm_source_file_free(source_file);
+		project_index->num_found--;
+	}
+}
+
+
+/* Removes the file or all files below the directory */
+static void remove_path(const gchar *locale_path)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gchar *prefix;
+	GPtrArray *files;
+	guint i;
+
+	if (g_hash_table_contains(project_index->source_files, locale_path))
+	{
+		remove_file(locale_path);
+		return;
+	}
+
+	prefix = g_strconcat(locale_path, G_DIR_SEPARATOR_S, NULL);
+	files = g_ptr_array_new_with_free_func(g_free);
+	g_hash_table_iter_init(&iter, project_index->source_files);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+	{
+		if (g_str_has_prefix(key, prefix))
+			g_ptr_array_add(files, g_strdup(key));
+	}
+	for (i = 0; i < files->len; i++)
+		remove_file(files->pdata[i]);
+	g_hash_table_remove(project_index->monitors, locale_path);
+
+	g_ptr_array_free(files, TRUE);
+	g_free(prefix);
+}
+
+
+static gboolean is_hidden(const gchar *locale_path)
+{
+	const gchar *name = strrchr(locale_path, G_DIR_SEPARATOR);
+
+	return name && name[1] == '.';
+}
+
+
+static gboolean is_in_project(const gchar *locale_path)
+{
+	gsize len = strlen(project_index->base_path);
+
+	return strncmp(locale_path, project_index->base_path, len) == 0 &&
+		locale_path[len] == G_DIR_SEPARATOR;
+}
+
+
+static void on_monitor_changed(GFileMonitor *monitor, GFile *file, GFile *other_file,
+		GFileMonitorEvent event_type, gpointer user_data)
+{
+	gchar *path = g_file_get_path(file);
+	gchar *other_path = other_file ? g_file_get_path(other_file) : NULL;
+
+	if (!path)
+		return;
+
+	switch (event_type)
+	{
+		case G_FILE_MONITOR_EVENT_RENAMED:
+			remove_path(path);
+			if (other_path)
+				SETPTR(path, g_strdup(other_path));
+			/* fall through */
+		case G_FILE_MONITOR_EVENT_CREATED:
+		case G_FILE_MONITOR_EVENT_MOVED_IN:
+		case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+			if (is_hidden(path))
+				break;
+			if (g_file_test(path, G_FILE_TEST_IS_DIR))
+			{
+				if (event_type != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT &&
+					!g_file_test(path, G_FILE_TEST_IS_SYMLINK))
+					queue_dir(path);
+			}
+			else if (is_index_candidate(path, NULL))
+				queue_file(path);
+			break;
+		case G_FILE_MONITOR_EVENT_DELETED:
+		case G_FILE_MONITOR_EVENT_MOVED_OUT:
+			remove_path(path);
+			break;
+		default:
+			break;
+	}
+
+	g_free(path);
+	g_free(other_path);
+}
+
+
+static void monitor_dir(const gchar *locale_dir)
+{
+	GFileMonitor *monitor;
+	GFile *file;
+
+	if (g_hash_table_size(project_index->monitors) >= INDEX_MAX_MONITORS ||
+		g_hash_table_contains(project_index->monitors, locale_dir))
+		return;
+
+	file = g_file_new_for_path(locale_dir);
+	monitor = g_file_monitor_directory(file, G_FILE_MONITOR_WATCH_MOVES, NULL, NULL);
+	if (monitor)
+	{
+		g_signal_connect(monitor, "changed", G_CALLBACK(on_monitor_changed), NULL);
+		g_hash_table_insert(project_index->monitors, g_strdup(locale_dir), monitor);
+	}
+	g_object_unref(file);
+}
+
+
+static void walk_dir(const gchar *locale_dir)
+{
+	GDir *dir = g_dir_open(locale_dir, 0, NULL);
+	const gchar *name;
+
+	if (!dir)
+		return;
+
+	/* the index may have become full since the directory was queued */
+	if (is_index_full())
+	{
+		g_dir_close(dir);
+		return;
+	}
+
+	monitor_dir(locale_dir);
+	while ((name = g_dir_read_name(dir)) != NULL && !is_index_full())
+	{
+		gchar *path;
+
+		/* skip hidden files and directories like .git */
+		if (name[0] == '.')
+			continue;
+
+		path = g_build_filename(locale_dir, name, NULL);
+		if (g_file_test(path, G_FILE_TEST_IS_DIR))
+		{
+			/* symlinked directories could lead into loops */
+			if (!g_file_test(path, G_FILE_TEST_IS_SYMLINK))
+				queue_dir(path);
+		}
+		else if (is_index_candidate(path, NULL))
+			queue_file(path);
+		g_free(path);
+	}
+	g_dir_close(dir);
+}
+
+
+/* Adds up to INDEX_BATCH_SIZE queued files to the workspace */
+static void add_files(void)
+{
+	GPtrArray *source_files = g_ptr_array_new();
+
+	while (source_files->len < INDEX_BATCH_SIZE && !g_queue_is_empty(&project_index->files))
+	{
+		gchar *locale_filename = g_queue_pop_head(&project_index->files);
+		const gchar *lang_name = NULL;
+		TMSourceFile *source_file;
+
+		g_hash_table_remove(project_index->queued, locale_filename);
+		/* reindex changed files */
+		if (g_hash_table_contains(project_index->source_files, locale_filename))
+		{
+			remove_file(locale_filename);
+			project_index->num_found++;
+		}
+
+		/* the open documents are parsed by document.c */
+		if (!document_find_by_real_path(locale_filename) &&
+			is_index_candidate(locale_filename, &lang_name) &&
+			(source_file = tm_source_file_new(locale_filename, lang_name)) != NULL)
+		{
+			g_hash_table_insert(project_index->source_files, locale_filename, source_file);
+			g_ptr_array_add(source_files, source_file);
+		}
+		else
+		{
+			project_index->num_found--;
+			g_free(locale_filename);
+		}
+	}
+
+	/* the workspace tags are updated once when all files are added */
+	if (source_files->len > 0 && tm_workspace_add_source_files_async(source_files, FALSE))
+		project_index->update_pending = TRUE;
+	project_index->num_added += source_files->len;
+	g_ptr_array_free(source_files, TRUE);
+}
+
+
+static guint count_symbols(void)
+{
+	GHashTableIter iter;
+	gpointer value;
+	guint count = 0;
+
+	g_hash_table_iter_init(&iter, project_index->source_files);
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+		count += ((TMSourceFile *) value)->tags_array->len;
+	return count;
+}
+
+
+static void update_status(gboolean done)
+{
+	gint64 now = g_get_monotonic_time();
+
+	if (done)
+	{
+		if (project_index->num_added > 0)
+			ui_set_statusbar(TRUE, _("Indexed %u project files (%u symbols)."),
+				g_hash_table_size(project_index->source_files), count_symbols());
+		project_index->num_added = 0;
+	}
+	else if (now - project_index->status_time >= INDEX_STATUS_INTERVAL)
+	{
+		ui_set_statusbar(FALSE, _("Indexing project files: %u of %u (%u symbols)..."),
+			g_hash_table_size(project_index->source_files), project_index->num_found,
+			count_symbols());
+		project_index->status_time = now;
+	}
+}
+
+
+static gboolean index_step(gpointer data)
+{
+	gint64 idle_time = g_get_monotonic_time() - last_edit_time;
+
+	project_index->step_id = 0;
+
+	/* let the user type undisturbed */
+	if (idle_time < INDEX_TYPING_PAUSE)
+	{
+		project_index->step_id = g_timeout_add_full(G_PRIORITY_LOW,
+			(guint) ((INDEX_TYPING_PAUSE - idle_time) / 1000) + 1, index_step, NULL, NULL);
+		return G_SOURCE_REMOVE;
+	}
+
+	if (!g_queue_is_empty(&project_index->dirs))
+	{
+		gchar *locale_dir = g_queue_pop_head(&project_index->dirs);
+
+		walk_dir(locale_dir);
+		g_free(locale_dir);
+	}
+	else if (!g_queue_is_empty(&project_index->files))
+		add_files();
+
+	if (g_queue_is_empty(&project_index->dirs) && g_queue_is_empty(&project_index->files))
+	{
+		if (project_index->update_pending)
+		{
+			tm_workspace_update();
+			project_index->update_pending = FALSE;
+		}
+		update_status(TRUE);
+		return G_SOURCE_REMOVE;
+	}
+
+	update_status(FALSE);
+	schedule_step();
+	return G_SOURCE_REMOVE;
+}
+
+
+static void schedule_step(void)
+{
+	if (project_index->step_id == 0)
+		project_index->step_id = g_idle_add_full(G_PRIORITY_LOW, index_step, NULL, NULL);
+}
+
+
+static void stop_index(void)
+{
+	GPtrArray *source_files;
+	GHashTableIter iter;
+	gpointer value;
+
+	if (!project_index)
+		return;
+
+	if (project_index->step_id != 0)
+		g_source_remove(project_index->step_id);
+
+	/* remove all files at once, this updates the workspace only once */
+	source_files = g_ptr_array_new_with_free_func((GDestroyNotify) tm_source_file_free);
+	g_hash_table_iter_init(&iter, project_index->source_files);
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+		g_ptr_array_add(source_files, value);
+	if (source_files->len > 0)
+		tm_workspace_remove_source_files(source_files);
+	g_ptr_array_free(source_files, TRUE);
+
+	g_hash_table_destroy(project_index->source_files);
+	g_hash_table_destroy(project_index->monitors);
+	g_hash_table_destroy(project_index->queued);
+	g_queue_foreach(&project_index->dirs, (GFunc) g_free, NULL);
+	g_queue_clear(&project_index->dirs);
+	g_queue_foreach(&project_index->files, (GFunc) g_free, NULL);
+	g_queue_clear(&project_index->files);
+	g_ptr_array_free(project_index->specs, TRUE);
+	g_strfreev(project_index->patterns);
+	g_free(project_index->base_path);
+	g_free(project_index);
+	project_index = NULL;
+}
+
+
+static void free_monitor(gpointer data)
+{
+	g_file_monitor_cancel(data);
+	g_object_unref(data);
+}
+
+
+static void start_index(const gchar *locale_base_path, gchar **patterns)
+{
+	gchar **pattern;
+
+	project_index = g_new0(ProjectIndex, 1);
+	project_index->base_path = g_strdup(locale_base_path);
+	project_index->patterns = g_strdupv(patterns);
+	project_index->specs = g_ptr_array_new_with_free_func((GDestroyNotify) g_pattern_spec_free);
+	foreach_strv(pattern, patterns)
+	{
+		if (!EMPTY(*pattern))
+			g_ptr_array_add(project_index->specs, g_pattern_spec_new(*pattern));
+	}
+	g_queue_init(&project_index->dirs);
+	g_queue_init(&project_index->files);
+	project_index->queued = g_hash_table_new(g_str_hash, g_str_equal);
+	project_index->source_files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	project_index->monitors = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_monitor);
+
+	queue_dir(locale_base_path);
+}
+
+
+static gboolean strv_equal(gchar **a, gchar **b)
+{
+	if (!a || !b)
+		return a == b;
+	for (; *a && *b; a++, b++)
+	{
+		if (!utils_str_equal(*a, *b))
+			return FALSE;
+	}
+	return *a == *b;
+}
+
+
+/* Starts, restarts or stops indexing the project files after the project or its
+ * base path or file patterns changed */
+void project_index_update(void)
+{
+	gchar *base_path = NULL;
+	gchar *locale_base_path = NULL;
+
+	if (app->project && editor_prefs.project_index_max_files > 0 && !main_status.quitting)
+		base_path = project_get_base_path();
+	if (base_path)
+	{
+		/* like the paths of the documents, so they can be compared */
+		locale_base_path = utils_get_locale_from_utf8(base_path);
+		if (g_file_test(locale_base_path, G_FILE_TEST_IS_DIR))
+			SETPTR(locale_base_path, utils_get_real_path(locale_base_path));
+		else
+			SETPTR(locale_base_path, NULL);
+	}
+
+	if (project_index && (!locale_base_path ||
+		!utils_str_equal(project_index->base_path, locale_base_path) ||
+		!strv_equal(project_index->patterns, app->project->file_patterns)))
+	{
+		stop_index();
+	}
+	if (!project_index && locale_base_path)
+		start_index(locale_base_path, app->project->file_patterns);
+
+	g_free(locale_base_path);
+	g_free(base_path);
+}
+
+
+/* The documents' own TMSourceFiles replace the ones of the index while open */
+static void on_document_open(GObject *obj, GeanyDocument *doc, gpointer user_data)
+{
+	if (project_index && doc->real_path)
+		remove_file(doc->real_path);
+}
+
+
+static void on_document_close(GObject *obj, GeanyDocument *doc, gpointer user_data)
+{
+	if (project_index && doc->real_path && is_in_project(doc->real_path) &&
+		!is_hidden(doc->real_path) && is_index_candidate(doc->real_path, NULL))
+	{
+		/* added to the workspace when the document is gone */
+		queue_file(doc->real_path);
+	}
+}
+
+
+static gboolean on_editor_notify(GObject *obj, GeanyEditor *editor, SCNotification *nt,
+		gpointer user_data)
+{
+	if (nt->nmhdr.code == SCN_MODIFIED &&
+		(nt->modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)))
+		last_edit_time = g_get_monotonic_time();
+	return FALSE;
+}
+
+
+void project_index_init(void)
+{
+	g_signal_connect(geany_object, "document-open", G_CALLBACK(on_document_open), NULL);
+	g_signal_connect(geany_object, "document-save", G_CALLBACK(on_document_open), NULL);
+	g_signal_connect(geany_object, "document-close", G_CALLBACK(on_document_close), NULL);
+	g_signal_connect(geany_object, "editor-notify", G_CALLBACK(on_editor_notify), NULL);
+}
+
+
+void project_index_finalize(void)
+{
+	stop_index();
+}
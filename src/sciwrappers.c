@@ -796,6 +796,17 @@ gchar *sci_get_contents(ScintillaObject *sci, gint buffer_len)
 }
 
 
+/* Gets a copy of the whole text which stays valid while the document is edited.
+ * Unlike SCI_GETCHARACTERPOINTER this doesn't move the gap of Scintilla's buffer to
+ * the end. The data is NUL terminated but the terminator isn't included in the size. */
+GBytes *sci_get_contents_bytes(ScintillaObject *sci)
+{
+	gint len = sci_get_length(sci);
+
+	return g_bytes_new_take(sci_get_contents(sci, len + 1), (gsize) len);
+}
+
+
 /** Gets selected text.
  * @deprecated sci_get_selected_text is deprecated and should not be used in newly-written code.
  * Use sci_get_selection_contents() instead.
@@ -112,6 +112,7 @@ gint				sci_get_selected_text_length(ScintillaObject *sci) GEANY_DEPRECATED_FOR(
 #ifdef GEANY_PRIVATE
 
 gchar*				sci_get_string				(ScintillaObject *sci, guint msg, gulong wParam);
+GBytes*				sci_get_contents_bytes		(ScintillaObject *sci);
 
 void 				sci_set_line_numbers		(ScintillaObject *sci,  gboolean set);
 void				sci_set_mark_long_lines		(ScintillaObject *sci,	gint type, gint column, const gchar *color);
@@ -34,6 +34,7 @@
 #include "document.h"
 #include "encodings.h"
 #include "encodingsprivate.h"
+#include "findinfiles.h"
 #include "keyfile.h"
 #include "msgwindow.h"
 #include "prefs.h"
@@ -41,6 +42,8 @@
 #include "spawn.h"
 #include "stash.h"
 #include "support.h"
+#include "tm_source_file.h"
+#include "tm_workspace.h"
 #include "toolbar.h"
 #include "ui_utils.h"
 #include "utils.h"
@@ -53,6 +56,8 @@
 #include <gdk/gdkkeysyms.h>
 
 #define MIN_DLG_BUTTON_SIZE 130
+/* maximum length of the text searched with a single Scintilla call in idle time searches */
+#define SEARCH_CHUNK_SIZE 65536
 
 enum
 {
@@ -149,15 +154,22 @@ static struct
 fif_dlg = {NULL, NULL, NULL, NULL, NULL, NULL, {0, 0}};
 
 
-static void search_read_io(GString *string, GIOCondition condition, gpointer data);
-static void search_read_io_stderr(GString *string, GIOCondition condition, gpointer data);
+static void search_read_io(const SpawnLine *lines, guint n_lines, GIOCondition condition,
+	gpointer data);
+static void search_read_io_stderr(const SpawnLine *lines, guint n_lines, GIOCondition condition,
+	gpointer data);
 
 static void search_finished(GPid child_pid, gint status, gpointer user_data);
+static void show_search_result(gint exit_status, gint count);
 
 static gchar **search_get_argv(const gchar **argv_prefix, const gchar *dir);
 
 static GRegex *compile_regex(const gchar *str, GeanyFindFlags sflags);
 
+static gint geany_find_flags_to_sci_flags(GeanyFindFlags flags);
+
+static void find_usage_cancel(void);
+
 
 static void
 on_find_replace_checkbutton_toggled(GtkToggleButton *togglebutton, gpointer user_data);
@@ -171,6 +183,9 @@ on_find_entry_activate(GtkEntry *entry, gpointer user_data);
 static void
 on_find_entry_activate_backward(GtkEntry *entry, gpointer user_data);
 
+static void
+on_find_entry_changed(GtkEditable *editable, gpointer user_data);
+
 static void
 on_replace_dialog_response(GtkDialog *dialog, gint response, gpointer user_data);
 
@@ -187,6 +202,9 @@ static gboolean
 search_find_in_files(const gchar *utf8_search_text, const gchar *dir, const gchar *opts,
 	const gchar *enc);
 
+static gboolean
+search_find_in_files_builtin(const gchar *utf8_search_text, const gchar *utf8_dir, const gchar *enc);
+
 
 static void init_prefs(void)
 {
@@ -293,6 +311,10 @@ void search_finalize(void)
 	FREE_WIDGET(find_dlg.dialog);
 	FREE_WIDGET(replace_dlg.dialog);
 	FREE_WIDGET(fif_dlg.dialog);
+	search_mark_all_cancel();
+	search_find_incremental_cancel();
+	find_usage_cancel();
+	fif_finalize();
 	g_free(search_data.text);
 	g_free(search_data.original_text);
 }
@@ -506,6 +528,8 @@ static void create_find_dialog(void)
 	ui_entry_add_activate_backward_signal(GTK_ENTRY(gtk_bin_get_child(GTK_BIN(entry))));
 	g_signal_connect(gtk_bin_get_child(GTK_BIN(entry)), "activate-backward",
 			G_CALLBACK(on_find_entry_activate_backward), entry);
+	g_signal_connect(gtk_bin_get_child(GTK_BIN(entry)), "changed",
+			G_CALLBACK(on_find_entry_changed), NULL);
 	g_signal_connect(find_dlg.dialog, "response",
 			G_CALLBACK(on_find_dialog_response), entry);
 	g_signal_connect(find_dlg.dialog, "delete-event",
@@ -998,7 +1022,8 @@ static void create_fif_dialog(void)
 	check_regexp = gtk_check_button_new_with_mnemonic(_("_Use regular expressions"));
 	ui_hookup_widget(fif_dlg.dialog, check_regexp, "check_regexp");
 	gtk_button_set_focus_on_click(GTK_BUTTON(check_regexp), FALSE);
-	gtk_widget_set_tooltip_text(check_regexp, _("See grep's manual page for more information"));
+	gtk_widget_set_tooltip_text(check_regexp, _("Use Perl-like regular expressions, or the extended "
+		"regular expressions of grep when it is used. For detailed information, please refer to the manual."));
 
 	check_recursive = gtk_check_button_new_with_mnemonic(_("_Recurse in subfolders"));
 	ui_hookup_widget(fif_dlg.dialog, check_recursive, "check_recursive");
@@ -1312,40 +1337,548 @@ static GSList *find_range(ScintillaObject *sci, GeanyFindFlags flags, struct Sci
 }
 
 
-/* Clears markers if text is null/empty.
- * @return Number of matches marked. */
-gint search_mark_all(GeanyDocument *doc, const gchar *search_text, GeanyFindFlags flags)
+/* Mark All: the visible part of the document is marked first, the rest in idle time.
+ * Every phase is time limited, since a single line on screen can be huge. */
+
+/* time to spend marking per idle call, in microseconds */
+#define MARK_ALL_SLICE_TIME 10000
+
+enum
 {
-	gint count = 0;
-	struct Sci_TextToFind ttf;
-	GSList *match, *matches;
+	MARK_ALL_VISIBLE,
+	MARK_ALL_BELOW,
+	MARK_ALL_ABOVE
+};
+
+typedef struct MarkAllJob
+{
+	GeanyDocument *doc;
+	guint doc_id;
+	gchar *text;
+	gsize text_len;
+	GeanyFindFlags flags;
+	gint sci_flags;
+	GRegex *regex;			/* NULL unless searching for a regex */
+	gint length;			/* document length, to detect changes */
+	gint visible_start;
+	gint visible_end;
+	gint phase;
+	gint pos;				/* where to continue searching */
+	gint fill_start;		/* range of adjacent matches not filled yet */
+	gint fill_end;
+	gint count;
+	gchar *report_text;		/* text to report the match count for when done, or NULL */
+	guint source_id;
+}
+MarkAllJob;
+
+static MarkAllJob *mark_all_job = NULL;
+
+
+static void mark_all_job_free(MarkAllJob *job)
+{
+	if (job->source_id)
+		g_source_remove(job->source_id);
+	if (job->regex)
+		g_regex_unref(job->regex);
+	g_free(job->text);
+	g_free(job->report_text);
+	g_free(job);
+}
+
+
+/* Stops marking matches in idle time, the matches already marked are kept */
+void search_mark_all_cancel(void)
+{
+	if (mark_all_job)
+	{
+		mark_all_job_free(mark_all_job);
+		mark_all_job = NULL;
+	}
+}
+
+
+static void mark_all_report(gint count, const gchar *original_text)
+{
+	if (count == 0)
+		ui_set_statusbar(FALSE, _("No matches found for \"%s\"."), original_text);
+	else
+		ui_set_statusbar(FALSE,
+			ngettext("Found %d match for \"%s\".",
+					 "Found %d matches for \"%s\".", count),
+			count, original_text);
+}
+
+
+static gboolean mark_all_find_regex(GRegex *regex, const gchar *text, gint length, gint pos,
+		gint offset, gint *start, gint *end)
+{
+	GMatchInfo *minfo;
+	gboolean found;
+
+	found = g_regex_match_full(regex, text, length, pos, 0, &minfo, NULL);
+	if (found)
+	{
+		g_match_info_fetch_pos(minfo, 0, start, end);
+		*start += offset;
+		*end += offset;
+	}
+	g_match_info_free(minfo);
+	return found;
+}
+
+
+/* Finds the first match starting between pos and limit */
+static gboolean mark_all_find(MarkAllJob *job, ScintillaObject *sci, gint pos, gint limit,
+		gint *start, gint *end)
+{
+	gint line, line_count;
+
+	if (! job->regex)
+	{
+		struct Sci_TextToFind ttf;
+
+		/* allow the match to end after limit */
+		ttf.chrg.cpMin = pos;
+		ttf.chrg.cpMax = (gint) MIN((gsize) limit + job->text_len, (gsize) job->length);
+		ttf.lpstrText = job->text;
+		if (sci_find_text(sci, job->sci_flags, &ttf) == -1 || ttf.chrgText.cpMin >= limit)
+			return FALSE;
+
+		*start = ttf.chrgText.cpMin;
+		*end = ttf.chrgText.cpMax;
+		return TRUE;
+	}
+
+	if (job->flags & GEANY_FIND_MULTILINE)
+	{
+		/* Warning: any SCI calls will invalidate 'text' after calling SCI_GETCHARACTERPOINTER */
+		const gchar *text = (const gchar *) SSM(sci, SCI_GETCHARACTERPOINTER, 0, 0);
+
+		return mark_all_find_regex(job->regex, text, job->length, pos, 0, start, end) &&
+			*start < limit;
+	}
+
+	/* single-line mode, match against each line like find_regex() */
+	line_count = sci_get_line_count(sci);
+	for (line = sci_get_line_from_position(sci, pos); line < line_count; line++)
+	{
+		gint line_start = sci_get_position_from_line(sci, line);
+		gint line_end = sci_get_line_end_position(sci, line);
+		const gchar *text;
+
+		if (line_start >= limit)
+			break;
+		if (pos > line_end)
+			continue;
+
+		text = (const gchar *) SSM(sci, SCI_GETRANGEPOINTER, line_start, line_end - line_start);
+		if (mark_all_find_regex(job->regex, text, line_end - line_start,
+				MAX(pos, line_start) - line_start, line_start, start, end))
+			return *start < limit;
+	}
+	return FALSE;
+}
+
+
+static void mark_all_flush(MarkAllJob *job, ScintillaObject *sci)
+{
+	if (job->fill_end > job->fill_start)
+		sci_indicator_fill(sci, job->fill_start, job->fill_end - job->fill_start);
+	job->fill_start = job->fill_end = 0;
+}
+
+
+/* Marks the matches starting between job->pos and limit, stopping at the deadline.
+ * @return Whether the range is done. */
+static gboolean mark_all_range(MarkAllJob *job, gint limit, gint64 deadline)
+{
+	ScintillaObject *sci = job->doc->editor->sci;
+	/* a multiline regex may scan the whole remaining text for the next match anyway */
+	gint chunk_size = (job->flags & GEANY_FIND_MULTILINE) ? G_MAXINT : SEARCH_CHUNK_SIZE;
+
+	sci_indicator_set(sci, GEANY_INDICATOR_SEARCH);
+	while (job->pos < limit)
+	{
+		gint chunk_end = limit - job->pos > chunk_size ? job->pos + chunk_size : limit;
+		gint start, end;
+
+		if (! mark_all_find(job, sci, job->pos, chunk_end, &start, &end))
+			job->pos = chunk_end;
+		else
+		{
+			job->count++;
+			if (end > start)
+			{
+				/* fill adjacent matches at once */
+				if (start != job->fill_end)
+				{
+					mark_all_flush(job, sci);
+					job->fill_start = start;
+				}
+				job->fill_end = end;
+				job->pos = end;
+			}
+			else /* avoid rematching an empty match, move past a whole character */
+				job->pos = sci_get_position_after(sci, end);
+		}
+
+		if (g_get_monotonic_time() >= deadline)
+			break;
+	}
+	mark_all_flush(job, sci);
+
+	return job->pos >= limit;
+}
+
+
+/* @return Whether the whole document is done. */
+static gboolean mark_all_step(MarkAllJob *job, gint64 deadline)
+{
+	if (job->phase == MARK_ALL_VISIBLE)
+	{
+		/* the visible range fits in the first slice except e.g. for very long lines */
+		if (! mark_all_range(job, job->visible_end, deadline))
+			return FALSE;
+		job->phase = MARK_ALL_BELOW;
+	}
+	if (job->phase == MARK_ALL_BELOW)
+	{
+		if (! mark_all_range(job, job->length, deadline))
+			return FALSE;
+		job->phase = MARK_ALL_ABOVE;
+		job->pos = 0;
+	}
+	return mark_all_range(job, job->visible_start, deadline);
+}
+
+
+static void mark_all_finish(MarkAllJob *job)
+{
+	if (job->report_text)
+		mark_all_report(job->count, job->report_text);
+
+	if (job == mark_all_job)
+		mark_all_job = NULL;
+	mark_all_job_free(job);
+}
 
-	g_return_val_if_fail(DOC_VALID(doc), 0);
 
+static gboolean mark_all_idle(gpointer data)
+{
+	MarkAllJob *job = data;
+
+	/* stop if the document was closed or changed */
+	if (! DOC_VALID(job->doc) || job->doc->id != job->doc_id ||
+		sci_get_length(job->doc->editor->sci) != job->length)
+	{
+		job->source_id = 0;
+		search_mark_all_cancel();
+		return FALSE;
+	}
+
+	if (! mark_all_step(job, g_get_monotonic_time() + MARK_ALL_SLICE_TIME))
+		return TRUE;
+
+	job->source_id = 0;
+	mark_all_finish(job);
+	return FALSE;
+}
+
+
+static void mark_all(GeanyDocument *doc, const gchar *search_text, GeanyFindFlags flags,
+		const gchar *report_text)
+{
+	ScintillaObject *sci;
+	MarkAllJob *job;
+	gint first_line, last_line;
+
+	g_return_if_fail(DOC_VALID(doc));
+
+	search_mark_all_cancel();
 	/* clear previous search indicators */
 	editor_indicator_clear(doc->editor, GEANY_INDICATOR_SEARCH);
 
 	if (G_UNLIKELY(EMPTY(search_text)))
-		return 0;
+	{
+		if (report_text)
+			mark_all_report(0, report_text);
+		return;
+	}
 
-	ttf.chrg.cpMin = 0;
-	ttf.chrg.cpMax = sci_get_length(doc->editor->sci);
-	ttf.lpstrText = (gchar *)search_text;
+	sci = doc->editor->sci;
+	job = g_new0(MarkAllJob, 1);
+	job->doc = doc;
+	job->doc_id = doc->id;
+	job->text = g_strdup(search_text);
+	job->text_len = strlen(search_text);
+	job->flags = flags;
+	job->report_text = g_strdup(report_text);
+	job->length = sci_get_length(sci);
 
-	matches = find_range(doc->editor->sci, flags, &ttf);
-	foreach_slist (match, matches)
+	if (flags & GEANY_FIND_REGEXP)
 	{
-		GeanyMatchInfo *info = match->data;
+		job->regex = compile_regex(search_text, flags);
+		if (! job->regex)
+		{
+			/* keep the error message in the status bar */
+			mark_all_job_free(job);
+			return;
+		}
+	}
+	else
+		job->sci_flags = geany_find_flags_to_sci_flags(flags);
+
+	first_line = sci_get_first_visible_line(sci);
+	last_line = first_line + (gint) SSM(sci, SCI_LINESONSCREEN, 0, 0);
+	first_line = (gint) SSM(sci, SCI_DOCLINEFROMVISIBLE, first_line, 0);
+	last_line = MIN((gint) SSM(sci, SCI_DOCLINEFROMVISIBLE, last_line, 0),
+		sci_get_line_count(sci) - 1);
+	job->visible_start = sci_get_position_from_line(sci, first_line);
+	job->visible_end = sci_get_line_end_position(sci, last_line);
+	job->pos = job->visible_start;
+
+	if (mark_all_step(job, g_get_monotonic_time() + MARK_ALL_SLICE_TIME))
+		mark_all_finish(job);
+	else
+	{
+		mark_all_job = job;
+		job->source_id = g_idle_add(mark_all_idle, job);
+	}
+}
 
-		if (info->end != info->start)
-			editor_indicator_set_on_range(doc->editor, GEANY_INDICATOR_SEARCH, info->start, info->end);
-		count++;
 
-		geany_match_info_free(info);
+/* Marks all matches in the document, or only clears the markers if text is null/empty.
+ * The visible matches are marked first, the others and any taking too long in idle time. */
+void search_mark_all(GeanyDocument *doc, const gchar *search_text, GeanyFindFlags flags)
+{
+	mark_all(doc, search_text, flags, NULL);
+}
+
+
+/* Incremental search bar find: when the text extends the previous one, the search continues
+ * where the previous one stopped, since the text cannot start anywhere the previous text
+ * did not. A search taking too long continues in idle time. */
+
+/* time to spend searching per key press or idle call, in microseconds */
+#define SEARCH_BAR_SLICE_TIME 15000
+/* minimum time between pulses of the entry progress, in microseconds */
+#define SEARCH_BAR_PULSE_TIME 100000
+
+enum
+{
+	SEARCH_BAR_PENDING,
+	SEARCH_BAR_FOUND,
+	SEARCH_BAR_NOT_FOUND
+};
+
+static struct
+{
+	GeanyDocument	*doc;
+	guint			doc_id;
+	gint			length;		/* document length, to detect changes */
+	gchar			*text;
+	gint			start_pos;	/* where the search started */
+	gint			pos;		/* the text does not start from start_pos up to here */
+	gboolean		wrapped;	/* whether pos wrapped around to the document start */
+	gint			caret;		/* selection start after the last step, to detect moves */
+	gint			status;
+	guint			source_id;
+	gint64			last_pulse;	/* when the entry progress last moved */
+}
+search_bar = {NULL, 0, 0, NULL, 0, 0, FALSE, 0, SEARCH_BAR_NOT_FOUND, 0, 0};
+
+
+/* Shows a pending search as progress inside the search bar entry rather than in the
+ * status bar progress bar, which belongs to builds and Find in Files */
+static void search_bar_set_busy(gboolean busy)
+{
+	GtkWidget *entry = toolbar_get_widget_child_by_name("SearchEntry");
+	gint64 now;
+
+	if (entry == NULL || ! GTK_IS_ENTRY(entry))
+		return;
+
+	if (! busy)
+	{
+		gtk_entry_set_progress_fraction(GTK_ENTRY(entry), 0.0);
+		return;
 	}
-	g_slist_free(matches);
+	now = g_get_monotonic_time();
+	if (now - search_bar.last_pulse >= SEARCH_BAR_PULSE_TIME)
+	{
+		gtk_entry_progress_pulse(GTK_ENTRY(entry));
+		search_bar.last_pulse = now;
+	}
+}
 
-	return count;
+
+void search_find_incremental_cancel(void)
+{
+	if (search_bar.source_id)
+	{
+		g_source_remove(search_bar.source_id);
+		search_bar.source_id = 0;
+		search_bar_set_busy(FALSE);
+	}
+	SETPTR(search_bar.text, NULL);
+}
+
+
+/* Searches forward from search_bar.pos, wrapping around to start_pos.
+ * @return The search status. */
+static gint search_bar_step(gint64 deadline)
+{
+	ScintillaObject *sci = search_bar.doc->editor->sci;
+	gint text_len = (gint) strlen(search_bar.text);
+
+	for (;;)
+	{
+		struct Sci_TextToFind ttf;
+		gint limit = search_bar.wrapped ? search_bar.start_pos : search_bar.length;
+		gint chunk_end;
+
+		if (search_bar.pos >= limit)
+		{
+			if (search_bar.wrapped)
+				return SEARCH_BAR_NOT_FOUND;
+			search_bar.wrapped = TRUE;
+			search_bar.pos = 0;
+			continue;
+		}
+
+		chunk_end = limit - search_bar.pos > SEARCH_CHUNK_SIZE ?
+			search_bar.pos + SEARCH_CHUNK_SIZE : limit;
+		/* allow the match to end after chunk_end */
+		ttf.chrg.cpMin = search_bar.pos;
+		ttf.chrg.cpMax = MIN(chunk_end + text_len, search_bar.length);
+		ttf.lpstrText = search_bar.text;
+		if (sci_find_text(sci, 0, &ttf) != -1 && ttf.chrgText.cpMin < chunk_end)
+		{
+			search_bar.pos = ttf.chrgText.cpMin;
+			document_show_search_bar_match(search_bar.doc, ttf.chrgText.cpMin, ttf.chrgText.cpMax);
+			return SEARCH_BAR_FOUND;
+		}
+		search_bar.pos = chunk_end;
+
+		if (g_get_monotonic_time() >= deadline)
+			return SEARCH_BAR_PENDING;
+	}
+}
+
+
+static void search_bar_show_status(void)
+{
+	ScintillaObject *sci = search_bar.doc->editor->sci;
+
+	if (search_bar.status == SEARCH_BAR_NOT_FOUND)
+	{
+		utils_beep();
+		sci_goto_pos(sci, search_bar.start_pos, FALSE);	/* clear selection */
+	}
+	search_bar.caret = sci_get_selection_start(sci);
+
+	if (search_data.search_bar)
+		ui_set_search_entry_background(toolbar_get_widget_child_by_name("SearchEntry"),
+			search_bar.status == SEARCH_BAR_FOUND);
+}
+
+
+static gboolean search_bar_idle(gpointer data)
+{
+	/* stop if the document was closed or changed */
+	if (! DOC_VALID(search_bar.doc) || search_bar.doc->id != search_bar.doc_id ||
+		sci_get_length(search_bar.doc->editor->sci) != search_bar.length)
+	{
+		search_bar.source_id = 0;
+		search_bar_set_busy(FALSE);
+		SETPTR(search_bar.text, NULL);
+		return FALSE;
+	}
+
+	search_bar.status = search_bar_step(g_get_monotonic_time() + SEARCH_BAR_SLICE_TIME);
+	if (search_bar.status == SEARCH_BAR_PENDING)
+	{
+		search_bar_set_busy(TRUE);
+		return TRUE;
+	}
+
+	search_bar.source_id = 0;
+	search_bar_set_busy(FALSE);
+	search_bar_show_status();
+	return FALSE;
+}
+
+
+/* Finds text forward from the selection start, as the search bar does while typing */
+void search_find_incremental(GeanyDocument *doc, const gchar *text)
+{
+	ScintillaObject *sci;
+	gboolean refine;
+
+	g_return_if_fail(DOC_VALID(doc));
+	g_return_if_fail(text != NULL);
+
+	sci = doc->editor->sci;
+	/* the previous search can be continued if nothing changed but the text was extended */
+	refine = search_bar.text != NULL && search_bar.doc == doc && search_bar.doc_id == doc->id &&
+		search_bar.length == sci_get_length(sci) &&
+		(search_bar.status == SEARCH_BAR_PENDING || search_bar.caret == sci_get_selection_start(sci)) &&
+		g_str_has_prefix(text, search_bar.text);
+
+	if (search_bar.source_id)
+	{
+		g_source_remove(search_bar.source_id);
+		search_bar.source_id = 0;
+		search_bar_set_busy(FALSE);
+	}
+
+	if (! *text)
+	{
+		SETPTR(search_bar.text, NULL);
+		if (search_data.search_bar)
+			ui_set_search_entry_background(toolbar_get_widget_child_by_name("SearchEntry"), TRUE);
+		return;
+	}
+
+	SETPTR(search_bar.text, g_strdup(text));
+	if (refine)
+	{
+		/* a longer text cannot be found where the previous one was not */
+		if (search_bar.status == SEARCH_BAR_NOT_FOUND)
+		{
+			search_bar_show_status();
+			return;
+		}
+		/* continue from the previous match, or where the previous search stopped */
+	}
+	else
+	{
+		search_bar.doc = doc;
+		search_bar.doc_id = doc->id;
+		search_bar.length = sci_get_length(sci);
+		search_bar.start_pos = sci_get_selection_start(sci);
+		search_bar.pos = search_bar.start_pos;
+		search_bar.wrapped = FALSE;
+	}
+
+	search_bar.status = search_bar_step(g_get_monotonic_time() + SEARCH_BAR_SLICE_TIME);
+	if (search_bar.status == SEARCH_BAR_PENDING)
+	{
+		search_bar.last_pulse = 0;
+		search_bar_set_busy(TRUE);
+		search_bar.source_id = g_idle_add(search_bar_idle, NULL);
+	}
+	else
+		search_bar_show_status();
+}
+
+
+static void
+on_find_entry_changed(GtkEditable *editable, gpointer user_data)
+{
+	/* stop marking the previous search text */
+	search_mark_all_cancel();
 }
 
 
@@ -1449,18 +1982,9 @@ on_find_dialog_response(GtkDialog *dialog, gint response, gpointer user_data)
 				break;
 
 			case GEANY_RESPONSE_MARK:
-			{
-				gint count = search_mark_all(doc, search_data.text, search_data.flags);
-
-				if (count == 0)
-					ui_set_statusbar(FALSE, _("No matches found for \"%s\"."), search_data.original_text);
-				else
-					ui_set_statusbar(FALSE,
-						ngettext("Found %d match for \"%s\".",
-								 "Found %d matches for \"%s\".", count),
-						count, search_data.original_text);
-			}
-			break;
+				/* the match count is reported when all the document is marked */
+				mark_all(doc, search_data.text, search_data.flags, search_data.original_text);
+				break;
 		}
 		if (check_close)
 			gtk_widget_hide(find_dlg.dialog);
@@ -1647,10 +2171,10 @@ fail:
 
 static void reset_msgwin(void)
 {
+	/* stop adding the results of a previous Find Usage */
+	find_usage_cancel();
 	gtk_notebook_set_current_page(GTK_NOTEBOOK(msgwindow.notebook), MSG_MESSAGE);
-	gtk_list_store_clear(msgwindow.store_msg);
-	// reset width after any long messages
-	gtk_tree_view_columns_autosize(GTK_TREE_VIEW(msgwindow.tree_msg));
+	msgwin_clear_tab(MSG_MESSAGE);
 }
 
 
@@ -1731,18 +2255,31 @@ on_find_in_files_dialog_response(GtkDialog *dialog, gint response,
 		}
 		else
 		{
-			GString *opts = get_grep_options();
 			const gchar *enc = (enc_idx == GEANY_ENCODING_UTF_8) ? NULL :
 				encodings_get_charset_from_index(enc_idx);
+			gboolean started;
 
-			if (search_find_in_files(search_text, utf8_dir, opts->str, enc))
+			g_strstrip(settings.fif_extra_options);
+			/* the built-in engine cannot handle grep options */
+			if (search_prefs.fif_use_grep ||
+				(settings.fif_use_extra_options && *settings.fif_extra_options))
+			{
+				GString *opts = get_grep_options();
+
+				fif_search_cancel();
+				started = search_find_in_files(search_text, utf8_dir, opts->str, enc);
+				g_string_free(opts, TRUE);
+			}
+			else
+				started = search_find_in_files_builtin(search_text, utf8_dir, enc);
+
+			if (started)
 			{
 				ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(search_combo), search_text, 0);
 				ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(fif_dlg.files_combo), NULL, 0);
 				ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(dir_combo), utf8_dir, 0);
 				gtk_widget_hide(fif_dlg.dialog);
 			}
-			g_string_free(opts, TRUE);
 		}
 		g_free(locale_dir);
 	}
@@ -1751,6 +2288,76 @@ on_find_in_files_dialog_response(GtkDialog *dialog, gint response,
 }
 
 
+static void on_fif_matches(const FifMatch *matches, guint n_matches, G_GNUC_UNUSED gpointer user_data)
+{
+	gchar **strings = g_new(gchar *, n_matches + 1);
+	guint i;
+
+	for (i = 0; i < n_matches; i++)
+	{
+		strings[i] = g_strdup_printf("%s:%u:%s",
+			matches[i].file, matches[i].line, matches[i].text);
+	}
+	strings[n_matches] = NULL;
+	msgwin_msg_add_strings(COLOR_BLACK, (const gchar * const *) strings, n_matches);
+	g_strfreev(strings);
+}
+
+
+static void on_fif_finished(guint n_matches, G_GNUC_UNUSED gpointer user_data)
+{
+	show_search_result(n_matches > 0 ? 0 : 1, n_matches);
+}
+
+
+/* Searches with the built-in engine instead of grep */
+static gboolean
+search_find_in_files_builtin(const gchar *utf8_search_text, const gchar *utf8_dir, const gchar *enc)
+{
+	FifOptions options;
+	gchar *dir, *utf8_str;
+	gchar **patterns = NULL;
+	GError *error = NULL;
+	gboolean ret;
+
+	g_strstrip(settings.fif_files);
+	if (settings.fif_files_mode != FILES_MODE_ALL && *settings.fif_files)
+		patterns = g_strsplit(settings.fif_files, " ", -1);
+
+	options.regexp = settings.fif_regexp;
+	options.case_sensitive = settings.fif_case_sensitive;
+	options.whole_word = settings.fif_match_whole_word;
+	options.invert = settings.fif_invert_results;
+	options.recursive = settings.fif_recursive;
+	options.file_patterns = patterns;
+	options.encoding = enc;
+
+	dir = utils_get_locale_from_utf8(utf8_dir);
+	ret = fif_search_start(utf8_search_text, dir, &options, on_fif_matches, on_fif_finished,
+		NULL, &error);
+	if (ret)
+	{
+		reset_msgwin();
+		ui_progress_bar_start(_("Searching..."));
+		msgwin_set_messages_dir(dir);
+		utf8_str = g_strdup_printf(_("Find in Files: %s (in directory: %s)"),
+			utf8_search_text, utf8_dir);
+		msgwin_msg_add_string(COLOR_BLUE, -1, NULL, utf8_str);
+		g_free(utf8_str);
+	}
+	else
+	{
+		ui_set_statusbar(FALSE, _("Bad regex: %s"), error->message);
+		ui_set_search_entry_background(fif_dlg.search_combo, FALSE);
+		g_error_free(error);
+	}
+
+	g_strfreev(patterns);
+	g_free(dir);
+	return ret;
+}
+
+
 static gboolean
 search_find_in_files(const gchar *utf8_search_text, const gchar *utf8_dir, const gchar *opts,
 	const gchar *enc)
@@ -1812,7 +2419,7 @@ search_find_in_files(const gchar *utf8_search_text, const gchar *utf8_dir, const
 
 	/* we can pass 'enc' without strdup'ing it here because it's a global const string and
 	 * always exits longer than the lifetime of this function */
-	if (spawn_with_callbacks(dir, command_line, argv, NULL, 0, NULL, NULL, search_read_io,
+	if (spawn_with_line_callbacks(dir, command_line, argv, NULL, 0, NULL, NULL, search_read_io,
 		(gpointer) enc, 0, search_read_io_stderr, (gpointer) enc, 0, search_finished, NULL,
 		NULL, &error))
  	{
@@ -1916,49 +2523,53 @@ static gchar **search_get_argv(const gchar **argv_prefix, const gchar *dir)
 }
 
 
-static void read_fif_io(gchar *msg, GIOCondition condition, gchar *enc, gint msg_color)
+static void read_fif_io(const SpawnLine *lines, guint n_lines, GIOCondition condition,
+	gchar *enc, gint msg_color)
 {
 	if (condition & (G_IO_IN | G_IO_PRI))
 	{
-		gchar *utf8_msg = NULL;
+		GPtrArray *msgs = g_ptr_array_new_full(n_lines, g_free);
+		guint i;
 
-		g_strstrip(msg);
-		/* enc is NULL when encoding is set to UTF-8, so we can skip any conversion */
-		if (enc != NULL)
+		for (i = 0; i < n_lines; i++)
 		{
-			if (! g_utf8_validate(msg, -1, NULL))
+			gchar *msg = g_strndup(lines[i].text, lines[i].length);
+
+			g_strstrip(msg);
+			/* enc is NULL when encoding is set to UTF-8, so we can skip any conversion */
+			if (enc != NULL && ! g_utf8_validate(msg, -1, NULL))
 			{
-				utf8_msg = g_convert(msg, -1, "UTF-8", enc, NULL, NULL, NULL);
+				gchar *utf8_msg = g_convert(msg, -1, "UTF-8", enc, NULL, NULL, NULL);
+
+				if (utf8_msg != NULL)
+					SETPTR(msg, utf8_msg);
 			}
-			if (utf8_msg == NULL)
-				utf8_msg = msg;
+			g_ptr_array_add(msgs, msg);
 		}
-		else
-			utf8_msg = msg;
 
-		msgwin_msg_add_string(msg_color, -1, NULL, utf8_msg);
-
-		if (utf8_msg != msg)
-			g_free(utf8_msg);
+		/* add the whole batch at once */
+		msgwin_msg_add_strings(msg_color, (const gchar * const *) msgs->pdata, msgs->len);
+		g_ptr_array_free(msgs, TRUE);
 	}
 }
 
 
-static void search_read_io(GString *string, GIOCondition condition, gpointer data)
+static void search_read_io(const SpawnLine *lines, guint n_lines, GIOCondition condition,
+	gpointer data)
 {
-	read_fif_io(string->str, condition, data, COLOR_BLACK);
+	read_fif_io(lines, n_lines, condition, data, COLOR_BLACK);
 }
 
 
-static void search_read_io_stderr(GString *string, GIOCondition condition, gpointer data)
+static void search_read_io_stderr(const SpawnLine *lines, guint n_lines, GIOCondition condition,
+	gpointer data)
 {
-	read_fif_io(string->str, condition, data, COLOR_DARK_RED);
+	read_fif_io(lines, n_lines, condition, data, COLOR_DARK_RED);
 }
 
 
 static void search_finished(GPid child_pid, gint status, gpointer user_data)
 {
-	const gchar *msg = _("Search failed.");
 	gint exit_status;
 
 	if (SPAWN_WIFEXITED(status))
@@ -1975,12 +2586,20 @@ static void search_finished(GPid child_pid, gint status, gpointer user_data)
 		exit_status = 1;
 	}
 
+	show_search_result(exit_status, exit_status == 0 ?
+		gtk_tree_model_iter_n_children(GTK_TREE_MODEL(msgwindow.store_msg), NULL) - 1 : 0);
+}
+
+
+/* Shows the result of Find in Files, exit_status being like the one of grep */
+static void show_search_result(gint exit_status, gint count)
+{
+	const gchar *msg = _("Search failed.");
+
 	switch (exit_status)
 	{
 		case 0:
 		{
-			gint count = gtk_tree_model_iter_n_children(
-				GTK_TREE_MODEL(msgwindow.store_msg), NULL) - 1;
 			gchar *text = g_strdup_printf(ngettext(
 						"Search completed with %d match.",
 						"Search completed with %d matches.", count),
@@ -2310,6 +2929,204 @@ static gint find_document_usage(GeanyDocument *doc, const gchar *search_text, Ge
 }
 
 
+static gboolean is_word_char(gchar c)
+{
+	return g_ascii_isalnum(c) || c == '_';
+}
+
+
+/* Whether the reference index of the workspace files can tell where text occurs */
+static gboolean can_use_reference_index(const gchar *text, GeanyFindFlags flags)
+{
+	const gchar *p;
+
+	if (flags != (GEANY_FIND_MATCHCASE | GEANY_FIND_WHOLEWORD))
+		return FALSE;
+	for (p = text; *p; p++)
+	{
+		if (!is_word_char(*p))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
+/* Adds the lines of a file which isn't open containing word as a whole word.
+ * The file is converted to UTF-8 first like when opening it, so that only
+ * UTF-8 text is searched and shown; files which can't be converted are skipped. */
+static gint find_file_usage(const gchar *locale_filename, const gchar *word)
+{
+	gchar *contents, *utf8_filename;
+	const gchar *line_start, *end;
+	gsize length, word_len = strlen(word);
+	gint count = 0;
+	gint line;
+
+	if (!g_file_get_contents(locale_filename, &contents, &length, NULL))
+		return 0;
+	if (!g_utf8_validate(contents, length, NULL))
+	{
+		gchar *utf8_contents = encodings_convert_to_utf8(contents, length, NULL);
+
+		g_free(contents);
+		if (!utf8_contents)
+			return 0;
+		contents = utf8_contents;
+		length = strlen(contents);
+	}
+
+	utf8_filename = utils_get_utf8_from_locale(locale_filename);
+	end = contents + length;
+	for (line_start = contents, line = 1; line_start < end; line++)
+	{
+		const gchar *line_end = memchr(line_start, '\n', end - line_start);
+		const gchar *p;
+		gint line_count = 0;
+
+		if (!line_end)
+			line_end = end;
+
+		for (p = line_start; p + word_len <= line_end; p++)
+		{
+			if (*p != *word || memcmp(p, word, word_len) != 0 ||
+				(p > line_start && is_word_char(p[-1])) ||
+				(p + word_len < line_end && is_word_char(p[word_len])))
+				continue;
+			line_count++;
+			p += word_len - 1;
+		}
+
+		if (line_count > 0)
+		{
+			gchar *text = g_strndup(line_start, line_end - line_start);
+
+			msgwin_msg_add(COLOR_BLACK, -1, NULL,
+				"%s:%d: %s", utf8_filename, line, g_strstrip(text));
+			g_free(text);
+			count += line_count;
+		}
+		line_start = line_end + 1;
+	}
+
+	g_free(utf8_filename);
+	g_free(contents);
+	return count;
+}
+
+
+/* Searches the open documents and collects the workspace files which aren't open
+ * but whose reference index contains word in files, so that files which don't can
+ * be skipped without reading them */
+static gint find_workspace_usage(const gchar *word, GeanyFindFlags flags, GPtrArray *files)
+{
+	const TMWorkspace *workspace = tm_get_workspace();
+	GHashTable *open_files = g_hash_table_new(g_str_hash, g_str_equal);
+	gint count = 0;
+	guint i;
+
+	/* the open documents may have changed since their last parse, search them
+	 * directly as before */
+	for (i = 0; i < documents_array->len; i++)
+	{
+		if (documents[i]->is_valid)
+		{
+			count += find_document_usage(documents[i], word, flags);
+			if (documents[i]->real_path)
+				g_hash_table_add(open_files, documents[i]->real_path);
+		}
+	}
+
+	for (i = 0; i < workspace->source_files->len; i++)
+	{
+		TMSourceFile *source_file = workspace->source_files->pdata[i];
+
+		/* files without an index are searched too */
+		if (!g_hash_table_contains(open_files, source_file->file_name) &&
+			tm_source_file_may_reference(source_file, word))
+		{
+			g_hash_table_add(open_files, source_file->file_name);
+			g_ptr_array_add(files, g_strdup(source_file->file_name));
+		}
+	}
+
+	g_hash_table_destroy(open_files);
+	return count;
+}
+
+
+static void find_usage_report(gint count, const gchar *original_search_text)
+{
+	if (count == 0) /* no matches were found */
+	{
+		ui_set_statusbar(FALSE, _("No matches found for \"%s\"."), original_search_text);
+		msgwin_msg_add(COLOR_BLUE, -1, NULL, _("No matches found for \"%s\"."), original_search_text);
+	}
+	else
+	{
+		ui_set_statusbar(FALSE, ngettext(
+			"Found %d match for \"%s\".", "Found %d matches for \"%s\".", count),
+			count, original_search_text);
+		msgwin_msg_add(COLOR_BLUE, -1, NULL, ngettext(
+			"Found %d match for \"%s\".", "Found %d matches for \"%s\".", count),
+			count, original_search_text);
+	}
+}
+
+
+/* The files which aren't open are read in idle time, so a word occurring in many
+ * files of a large project doesn't block the user interface */
+
+/* time to spend reading files per idle call, in microseconds */
+#define FIND_USAGE_SLICE_TIME 20000
+
+static struct
+{
+	gchar		*word;
+	gchar		*original_text;
+	GPtrArray	*files;		/* locale file names still to search */
+	guint		index;		/* the next file to search */
+	gint		count;
+	guint		source_id;
+}
+find_usage_job = {NULL, NULL, NULL, 0, 0, 0};
+
+
+static void find_usage_cancel(void)
+{
+	if (find_usage_job.source_id)
+	{
+		g_source_remove(find_usage_job.source_id);
+		find_usage_job.source_id = 0;
+	}
+	SETPTR(find_usage_job.word, NULL);
+	SETPTR(find_usage_job.original_text, NULL);
+	if (find_usage_job.files)
+	{
+		g_ptr_array_free(find_usage_job.files, TRUE);
+		find_usage_job.files = NULL;
+	}
+}
+
+
+static gboolean find_usage_idle(gpointer data)
+{
+	gint64 deadline = g_get_monotonic_time() + FIND_USAGE_SLICE_TIME;
+
+	while (find_usage_job.index < find_usage_job.files->len)
+	{
+		find_usage_job.count += find_file_usage(
+			find_usage_job.files->pdata[find_usage_job.index++], find_usage_job.word);
+		if (g_get_monotonic_time() >= deadline)
+			return TRUE;
+	}
+
+	find_usage_job.source_id = 0;
+	find_usage_report(find_usage_job.count, find_usage_job.original_text);
+	find_usage_cancel();
+	return FALSE;
+}
+
+
 void search_find_usage(const gchar *search_text, const gchar *original_search_text,
 		GeanyFindFlags flags, gboolean in_session)
 {
@@ -2330,6 +3147,24 @@ void search_find_usage(const gchar *search_text, const gchar *original_search_te
 	{	/* use current document */
 		count = find_document_usage(doc, search_text, flags);
 	}
+	else if (can_use_reference_index(search_text, flags))
+	{
+		GPtrArray *files = g_ptr_array_new_with_free_func(g_free);
+
+		count = find_workspace_usage(search_text, flags, files);
+		if (files->len > 0)
+		{
+			/* the count is reported when all files are searched */
+			find_usage_job.word = g_strdup(search_text);
+			find_usage_job.original_text = g_strdup(original_search_text);
+			find_usage_job.files = files;
+			find_usage_job.index = 0;
+			find_usage_job.count = count;
+			find_usage_job.source_id = g_idle_add(find_usage_idle, NULL);
+			return;
+		}
+		g_ptr_array_free(files, TRUE);
+	}
 	else
 	{
 		guint i;
@@ -2342,20 +3177,7 @@ void search_find_usage(const gchar *search_text, const gchar *original_search_te
 		}
 	}
 
-	if (count == 0) /* no matches were found */
-	{
-		ui_set_statusbar(FALSE, _("No matches found for \"%s\"."), original_search_text);
-		msgwin_msg_add(COLOR_BLUE, -1, NULL, _("No matches found for \"%s\"."), original_search_text);
-	}
-	else
-	{
-		ui_set_statusbar(FALSE, ngettext(
-			"Found %d match for \"%s\".", "Found %d matches for \"%s\".", count),
-			count, original_search_text);
-		msgwin_msg_add(COLOR_BLUE, -1, NULL, ngettext(
-			"Found %d match for \"%s\".", "Found %d matches for \"%s\".", count),
-			count, original_search_text);
-	}
+	find_usage_report(count, original_search_text);
 }
 
 
@@ -63,6 +63,7 @@ typedef struct GeanySearchPrefs
 	GeanyFindSelOptions find_selection_type;
 	gboolean	skip_confirmation_for_replace_in_session;	/* do *not* ask for confirmation
 															   before using "replace in session */
+	gboolean	fif_use_grep;			/* find in files with the grep tool instead of the built-in search */
 }
 GeanySearchPrefs;
 
@@ -136,7 +137,13 @@ void search_find_usage(const gchar *search_text, const gchar *original_search_te
 
 void search_find_selection(struct GeanyDocument *doc, gboolean search_backwards);
 
-gint search_mark_all(struct GeanyDocument *doc, const gchar *search_text, GeanyFindFlags flags);
+void search_mark_all(struct GeanyDocument *doc, const gchar *search_text, GeanyFindFlags flags);
+
+void search_mark_all_cancel(void);
+
+void search_find_incremental(struct GeanyDocument *doc, const gchar *text);
+
+void search_find_incremental_cancel(void);
 
 gint search_replace_match(struct _ScintillaObject *sci, const GeanyMatchInfo *match, const gchar *replace_text);
 
@@ -850,11 +850,15 @@ typedef struct _SpawnChannelData
 	{
 		GIOFunc write;
 		SpawnReadFunc read;
+		SpawnReadLinesFunc read_lines;
 	} cb;
 	gpointer cb_data;
 	/* stdout/stderr only */
-	GString *buffer;       /* NULL if recursive */
+	GString *buffer;       /* NULL if recursive or with read_lines */
 	GString *line_buffer;  /* NULL if char buffered */
+	gsize line_start;      /* start of the first line not passed yet */
+	gsize line_scan;       /* position up to which line_buffer was searched for line ends */
+	GArray *lines;         /* SpawnLine, NULL unless read_lines */
 	gsize max_length;
 	/* stdout/stderr: fix continuous empty G_IO_IN-s for recursive channels */
 	guint empty_gio_ins;
@@ -872,6 +876,9 @@ static void spawn_destroy_common(SpawnChannelData *sc)
 
 	if (sc->line_buffer)
 		g_string_free(sc->line_buffer, TRUE);
+
+	if (sc->lines)
+		g_array_free(sc->lines, TRUE);
 }
 
 
@@ -918,11 +925,98 @@ static gboolean spawn_timeout_read_cb(gpointer data)
 	return spawn_read_cb(sc->channel, G_IO_IN, data);
 }
 
+
+/* Moves the data not passed yet to the start of the line buffer. The lines are not
+ * removed from the buffer one by one, which would move the rest of the data each time. */
+static void spawn_compact_line_buffer(SpawnChannelData *sc)
+{
+	GString *line_buffer = sc->line_buffer;
+
+	if (sc->line_start > 0)
+	{
+		gsize rest = line_buffer->len - sc->line_start;
+
+		memmove(line_buffer->str, line_buffer->str + sc->line_start, rest);
+		g_string_set_size(line_buffer, rest);
+		sc->line_scan -= sc->line_start;
+		sc->line_start = 0;
+	}
+}
+
+
+static void spawn_pass_line(SpawnChannelData *sc, GString *buffer, const gchar *text, gsize length,
+	GIOCondition condition)
+{
+	if (sc->lines)
+	{
+		SpawnLine line = { text, length };
+
+		g_array_append_val(sc->lines, line);
+	}
+	else
+	{
+		g_string_truncate(buffer, 0);
+		g_string_append_len(buffer, text, length);
+		sc->cb.read(buffer, condition, sc->cb_data);
+	}
+}
+
+
+static void spawn_pass_lines(SpawnChannelData *sc, GIOCondition condition)
+{
+	if (sc->lines->len > 0 || (condition & SPAWN_IO_FAILURE))
+	{
+		sc->cb.read_lines((const SpawnLine *) (gpointer) sc->lines->data, sc->lines->len,
+			condition, sc->cb_data);
+		g_array_set_size(sc->lines, 0);
+	}
+}
+
+
+/* Passes the complete lines of the line buffer to the callback */
+static void spawn_split_lines(SpawnChannelData *sc, GString *buffer, GIOCondition condition)
+{
+	GString *line_buffer = sc->line_buffer;
+	gsize n = sc->line_scan;
+
+	while (n < line_buffer->len)
+	{
+		gchar c = line_buffer->str[n];
+		gsize line_end = 0;
+
+		if (n - sc->line_start == sc->max_length)
+			line_end = n;
+		else if (c == '\n' || c == '\0')
+			line_end = n + 1;
+		else if (c == '\r' && n < line_buffer->len - 1)
+			line_end = n + 1 + (line_buffer->str[n + 1] == '\n');
+
+		if (!line_end)
+			n++;
+		else
+		{
+			gsize line_start = sc->line_start;
+
+			/* update the positions first, a recursive callback may read more lines */
+			sc->line_start = sc->line_scan = line_end;
+			/* input only, failures are reported separately */
+			spawn_pass_line(sc, buffer, line_buffer->str + line_start, line_end - line_start,
+				condition);
+			n = sc->line_scan;
+		}
+	}
+	sc->line_scan = n;
+
+	if (sc->lines)
+		spawn_pass_lines(sc, condition);
+}
+
+
 static gboolean spawn_read_cb(GIOChannel *channel, GIOCondition condition, gpointer data)
 {
 	SpawnChannelData *sc = (SpawnChannelData *) data;
 	GString *line_buffer = sc->line_buffer;
-	GString *buffer = sc->buffer ? sc->buffer : g_string_sized_new(sc->max_length);
+	GString *buffer = sc->buffer || sc->lines ? sc->buffer : g_string_sized_new(sc->max_length);
 	GIOCondition input_cond = condition & (G_IO_IN | G_IO_PRI);
 	GIOCondition failure_cond = condition & SPAWN_IO_FAILURE;
 	GIOStatus status = G_IO_STATUS_NORMAL;
@@ -941,36 +1035,16 @@ static gboolean spawn_read_cb(GIOChannel *channel, GIOCondition condition, gpoin
 
 		if (line_buffer)
 		{
-			gsize n = line_buffer->len;
+			/* the data not passed yet is at most max_length long, so there is always
+			 * room for DEFAULT_IO_LENGTH more after compacting */
+			spawn_compact_line_buffer(sc);
 
-			while ((status = g_io_channel_read_chars(channel, line_buffer->str + n,
+			while ((status = g_io_channel_read_chars(channel, line_buffer->str + line_buffer->len,
 				DEFAULT_IO_LENGTH, &chars_read, NULL)) == G_IO_STATUS_NORMAL)
 			{
-				g_string_set_size(line_buffer, n + chars_read);
-
-				while (n < line_buffer->len)
-				{
-					gsize line_len = 0;
-
-					if (n == sc->max_length)
-						line_len = n;
-					else if (strchr("\n", line_buffer->str[n]))  /* '\n' or '\0' */
-						line_len = n + 1;
-					else if (n < line_buffer->len - 1 && line_buffer->str[n] == '\r')
-						line_len = n + 1 + (line_buffer->str[n + 1] == '\n');
-
-					if (!line_len)
-						n++;
-					else
-					{
-						g_string_append_len(buffer, line_buffer->str, line_len);
-						g_string_erase(line_buffer, 0, line_len);
-						/* input only, failures are reported separately below */
-						sc->cb.read(buffer, input_cond, sc->cb_data);
-						g_string_truncate(buffer, 0);
-						n = 0;
-					}
-				}
+				g_string_set_size(line_buffer, line_buffer->len + chars_read);
+				spawn_split_lines(sc, buffer, input_cond);
+				spawn_compact_line_buffer(sc);
 
 				if (SPAWN_CHANNEL_GIO_WATCH(sc) && !failure_cond)
 					break;
@@ -1001,20 +1075,37 @@ static gboolean spawn_read_cb(GIOChannel *channel, GIOCondition condition, gpoin
 
 	if (failure_cond)  /* we must signal the callback */
 	{
-		if (line_buffer && line_buffer->len)  /* flush the line buffer */
+		gsize rest = line_buffer ? line_buffer->len - sc->line_start : 0;
+
+		if (rest)  /* flush the line buffer */
 		{
-			g_string_append_len(buffer, line_buffer->str, line_buffer->len);
 			/* all data may be from a previous call */
 			if (!input_cond)
 				input_cond = G_IO_IN;
 		}
 		else
-		{
 			input_cond = 0;
+
+		if (sc->lines)
+		{
+			if (rest)
+			{
+				SpawnLine line = { line_buffer->str + sc->line_start, rest };
+
+				g_array_append_val(sc->lines, line);
+			}
+			spawn_pass_lines(sc, input_cond | failure_cond);
+		}
+		else
+		{
 			g_string_truncate(buffer, 0);
+			if (rest)
+				g_string_append_len(buffer, line_buffer->str + sc->line_start, rest);
+			sc->cb.read(buffer, input_cond | failure_cond, sc->cb_data);
 		}
 
-		sc->cb.read(buffer, input_cond | failure_cond, sc->cb_data);
+		if (line_buffer)
+			sc->line_start = sc->line_scan = line_buffer->len;
 	}
 	/* Check for continuous activations with G_IO_IN | G_IO_PRI, without any
 	   data to read and without errors. If detected, switch to timeout source. */
@@ -1113,6 +1204,14 @@ static void spawn_watch_cb(GPid pid, gint status, gpointer data)
 }
 
 
+static gboolean spawn_with_callbacks_common(const gchar *working_directory,
+	const gchar *command_line, gchar **argv, gchar **envp, SpawnFlags spawn_flags,
+	GIOFunc stdin_cb, gpointer stdin_data, GCallback stdout_cb, gpointer stdout_data,
+	gsize stdout_max_length, GCallback stderr_cb, gpointer stderr_data, gsize stderr_max_length,
+	gboolean read_lines, GChildWatchFunc exit_cb, gpointer exit_data, GPid *child_pid,
+	GError **error);
+
+
 /** @girskip
  *  Executes a child program and setups callbacks.
  *
@@ -1172,6 +1271,42 @@ gboolean spawn_with_callbacks(const gchar *working_directory, const gchar *comma
 	SpawnReadFunc stdout_cb, gpointer stdout_data, gsize stdout_max_length,
 	SpawnReadFunc stderr_cb, gpointer stderr_data, gsize stderr_max_length,
 	GChildWatchFunc exit_cb, gpointer exit_data, GPid *child_pid, GError **error)
+{
+	return spawn_with_callbacks_common(working_directory, command_line, argv, envp, spawn_flags,
+		stdin_cb, stdin_data, (GCallback) stdout_cb, stdout_data, stdout_max_length,
+		(GCallback) stderr_cb, stderr_data, stderr_max_length, FALSE, exit_cb, exit_data,
+		child_pid, error);
+}
+
+
+/*
+ *  Executes a child program and setups callbacks, like spawn_with_callbacks(), but passes
+ *  the child output to the callbacks as arrays of lines pointing into the spawn buffers,
+ *  without copying them. The output is always line buffered, and the stdout/stderr
+ *  callbacks may not be recursive.
+ */
+gboolean spawn_with_line_callbacks(const gchar *working_directory, const gchar *command_line,
+	gchar **argv, gchar **envp, SpawnFlags spawn_flags, GIOFunc stdin_cb, gpointer stdin_data,
+	SpawnReadLinesFunc stdout_cb, gpointer stdout_data, gsize stdout_max_length,
+	SpawnReadLinesFunc stderr_cb, gpointer stderr_data, gsize stderr_max_length,
+	GChildWatchFunc exit_cb, gpointer exit_data, GPid *child_pid, GError **error)
+{
+	g_return_val_if_fail(!(spawn_flags & (SPAWN_STDOUT_RECURSIVE | SPAWN_STDERR_RECURSIVE |
+		SPAWN_STDOUT_UNBUFFERED | SPAWN_STDERR_UNBUFFERED)), FALSE);
+
+	return spawn_with_callbacks_common(working_directory, command_line, argv, envp, spawn_flags,
+		stdin_cb, stdin_data, (GCallback) stdout_cb, stdout_data, stdout_max_length,
+		(GCallback) stderr_cb, stderr_data, stderr_max_length, TRUE, exit_cb, exit_data,
+		child_pid, error);
+}
+
+
+static gboolean spawn_with_callbacks_common(const gchar *working_directory,
+	const gchar *command_line, gchar **argv, gchar **envp, SpawnFlags spawn_flags,
+	GIOFunc stdin_cb, gpointer stdin_data, GCallback stdout_cb, gpointer stdout_data,
+	gsize stdout_max_length, GCallback stderr_cb, gpointer stderr_data, gsize stderr_max_length,
+	gboolean read_lines, GChildWatchFunc exit_cb, gpointer exit_data, GPid *child_pid,
+	GError **error)
 {
 	GPid pid;
 	int pipe[3] = { -1, -1, -1 };
@@ -1227,15 +1362,21 @@ gboolean spawn_with_callbacks(const gchar *working_directory, const gchar *comma
 				condition = G_IO_IN | G_IO_PRI | SPAWN_IO_FAILURE;
 				callback = spawn_read_cb;
 
+				if (read_lines)
+				{
+					sc->cb.read_lines = (SpawnReadLinesFunc) (i == 1 ? stdout_cb : stderr_cb);
+					sc->lines = g_array_new(FALSE, FALSE, sizeof(SpawnLine));
+				}
+				else
+					sc->cb.read = (SpawnReadFunc) (i == 1 ? stdout_cb : stderr_cb);
+
 				if (i == 1)
 				{
-					sc->cb.read = stdout_cb;
 					sc->max_length = stdout_max_length ? stdout_max_length :
 						line_buffered ? 24576 : DEFAULT_IO_LENGTH;
 				}
 				else
 				{
-					sc->cb.read = stderr_cb;
 					sc->max_length = stderr_max_length ? stderr_max_length :
 						line_buffered ? 8192 : DEFAULT_IO_LENGTH;
 				}
@@ -1254,7 +1395,7 @@ gboolean spawn_with_callbacks(const gchar *working_directory, const gchar *comma
 
 			if (spawn_flags & (SPAWN_STDIN_RECURSIVE << i))
 				g_source_set_can_recurse(source, TRUE);
-			else if (i)  /* to avoid new string on each call */
+			else if (i && !read_lines)  /* to avoid new string on each call */
 				sc->buffer = g_string_sized_new(sc->max_length);
 
 			g_source_set_callback(source, (GSourceFunc) (void(*)(void)) callback, sc, spawn_destroy_cb);
@@ -101,6 +101,30 @@ gboolean spawn_sync(const gchar *working_directory, const gchar *command_line, g
 	gchar **envp, SpawnWriteData *stdin_data, GString *stdout_data, GString *stderr_data,
 	gint *exit_status, GError **error);
 
+
+#if defined(GEANY_PRIVATE) || defined(SPAWN_TEST)
+
+/* A line of child output, pointing into the spawn buffer. The text is not nul-terminated
+ * and includes the line termination, if any. */
+typedef struct SpawnLine
+{
+	const gchar *text;
+	gsize length;
+} SpawnLine;
+
+/* Like SpawnReadFunc, but receives all the lines read at once. The lines are only valid
+ * during the call. n_lines may be 0 if only failure bits are set in condition. */
+typedef void (*SpawnReadLinesFunc)(const SpawnLine *lines, guint n_lines, GIOCondition condition,
+	gpointer data);
+
+gboolean spawn_with_line_callbacks(const gchar *working_directory, const gchar *command_line,
+	gchar **argv, gchar **envp, SpawnFlags spawn_flags, GIOFunc stdin_cb, gpointer stdin_data,
+	SpawnReadLinesFunc stdout_cb, gpointer stdout_data, gsize stdout_max_length,
+	SpawnReadLinesFunc stderr_cb, gpointer stderr_data, gsize stderr_max_length,
+	GChildWatchFunc exit_cb, gpointer exit_data, GPid *child_pid, GError **error);
+
+#endif /* GEANY_PRIVATE || SPAWN_TEST */
+
 G_END_DECLS
 
 #endif  /* GEANY_SPAWN_H */
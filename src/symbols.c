@@ -62,6 +62,7 @@
 #include <ctype.h>
 #include <string.h>
 #include <stdlib.h>
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
 
 
@@ -75,6 +76,15 @@ typedef struct
 
 static GPtrArray *top_level_iter_names = NULL;
 
+/* cached workspace typename keywords, see symbols_get_typename_keywords() */
+typedef struct
+{
+	guint version;
+	gchar *keywords;
+} TypenameKeywords;
+
+static GHashTable *typename_keywords = NULL;
+
 
 static struct
 {
@@ -106,7 +116,7 @@ static struct
 }
 symbol_menu;
 
-static void load_user_tags(GeanyFiletypeID ft_id);
+static void collect_user_tags(GeanyFiletypeID ft_id, GPtrArray *tags_files, GPtrArray *file_types);
 
 /* get the tags_ignore list, exported by geany_lcpp.c */
 extern gchar **c_tags_ignore;
@@ -175,10 +185,36 @@ static gboolean symbols_load_global_tags(const gchar *tags_file, GeanyFiletype *
 }
 
 
+/* Adds the not yet loaded global tags files of the file_type_idx filetype and
+ * of the filetypes whose tags it uses as well to tags_files. */
+static void collect_global_tags(guint file_type_idx, GPtrArray *tags_files, GPtrArray *file_types)
+{
+	/* load config in case of custom filetypes */
+	filetypes_load_config(file_type_idx, FALSE);
+
+	collect_user_tags(file_type_idx, tags_files, file_types);
+
+	switch (file_type_idx)
+	{
+		case GEANY_FILETYPES_CPP:
+			collect_global_tags(GEANY_FILETYPES_C, tags_files, file_types);	/* load C global tags */
+			break;
+		case GEANY_FILETYPES_PHP:
+			collect_global_tags(GEANY_FILETYPES_HTML, tags_files, file_types);	/* load HTML global tags */
+			break;
+	}
+}
+
+
 /* Ensure that the global tags file(s) for the file_type_idx filetype is loaded.
  * This provides autocompletion, calltips, etc. */
 void symbols_global_tags_loaded(guint file_type_idx)
 {
+	GPtrArray *tags_files, *file_types;
+	TMParserType *modes;
+	gint *tag_counts;
+	guint i;
+
 	/* load ignore list for C/C++ parser */
 	if ((file_type_idx == GEANY_FILETYPES_C || file_type_idx == GEANY_FILETYPES_CPP) &&
 		c_tags_ignore == NULL)
@@ -189,20 +225,30 @@ void symbols_global_tags_loaded(guint file_type_idx)
 	if (cl_options.ignore_global_tags || app->tm_workspace == NULL)
 		return;
 
-	/* load config in case of custom filetypes */
-	filetypes_load_config(file_type_idx, FALSE);
+	tags_files = g_ptr_array_new();
+	file_types = g_ptr_array_new();
+	collect_global_tags(file_type_idx, tags_files, file_types);
 
-	load_user_tags(file_type_idx);
+	/* load all files in one batch so that the global tags are only merged once */
+	modes = g_new(TMParserType, tags_files->len);
+	tag_counts = g_new(gint, tags_files->len);
+	for (i = 0; i < file_types->len; i++)
+		modes[i] = ((GeanyFiletype *) file_types->pdata[i])->lang;
 
-	switch (file_type_idx)
+	tm_workspace_load_global_tags_files((const gchar **) tags_files->pdata, modes,
+		tags_files->len, tag_counts);
+
+	for (i = 0; i < tags_files->len; i++)
 	{
-		case GEANY_FILETYPES_CPP:
-			symbols_global_tags_loaded(GEANY_FILETYPES_C);	/* load C global tags */
-			break;
-		case GEANY_FILETYPES_PHP:
-			symbols_global_tags_loaded(GEANY_FILETYPES_HTML);	/* load HTML global tags */
-			break;
+		if (tag_counts[i] >= 0)
+			geany_debug("Loaded %s (%s), %d symbol(s).", (gchar *) tags_files->pdata[i],
+				((GeanyFiletype *) file_types->pdata[i])->name, tag_counts[i]);
 	}
+
+	g_free(tag_counts);
+	g_free(modes);
+	g_ptr_array_free(file_types, TRUE);
+	g_ptr_array_free(tags_files, TRUE);
 }
 
 
@@ -243,6 +289,49 @@ GString *symbols_find_typenames_as_string(TMParserType lang, gboolean global)
 }
 
 
+static void free_typename_keywords(gpointer data)
+{
+	TypenameKeywords *entry = data;
+
+	g_free(entry->keywords);
+	g_free(entry);
+}
+
+
+/* Gets the workspace typenames for files of lang as a string of space separated
+ * keywords. The string is only rebuilt when the typenames of lang changed and
+ * is shared by all documents of the language.
+ * version: location to store the typenames version of the returned keywords.
+ * Returns: the keywords, or NULL if there are no typenames. */
+const gchar *symbols_get_typename_keywords(TMParserType lang, guint *version)
+{
+	TypenameKeywords *entry;
+
+	*version = tm_workspace_get_typenames_version(lang);
+	if (*version == 0)
+		return NULL;
+
+	if (!typename_keywords)
+		typename_keywords = g_hash_table_new_full(NULL, NULL, NULL, free_typename_keywords);
+
+	entry = g_hash_table_lookup(typename_keywords, GINT_TO_POINTER(lang));
+	if (!entry)
+	{
+		entry = g_new0(TypenameKeywords, 1);
+		g_hash_table_insert(typename_keywords, GINT_TO_POINTER(lang), entry);
+	}
+	if (entry->version != *version || !entry->keywords)
+	{
+		GString *s = symbols_find_typenames_as_string(lang, FALSE);
+
+		g_free(entry->keywords);
+		entry->keywords = s ? g_string_free(s, FALSE) : g_strdup("");
+		entry->version = *version;
+	}
+	return entry->keywords;
+}
+
+
 /** Gets the context separator used by the tag manager for a particular file
  * type.
  * @param ft_id File type identifier.
@@ -1261,12 +1350,171 @@ static GeanyFiletype *detect_global_tags_filetype(const gchar *utf8_filename)
 }
 
 
+typedef struct
+{
+	GMainLoop *loop;
+	guint running;
+} TagsWorkers;
+
+typedef struct
+{
+	TagsWorkers *workers;
+	gchar *shard;		/* the binary tags file written by the worker */
+	gint start, end;	/* the range of files parsed by the worker */
+	gboolean failed;
+} TagsWorker;
+
+
+static void on_tags_worker_exit(GPid pid, gint status, gpointer data)
+{
+	TagsWorker *worker = data;
+	GError *error = NULL;
+
+	if (! g_spawn_check_exit_status(status, &error))
+	{
+		/* also happens if the worker found no symbols, parsing again tells */
+		geany_debug("Tags worker process for %s failed: %s", worker->shard, error->message);
+		g_error_free(error);
+		worker->failed = TRUE;
+	}
+	g_spawn_close_pid(pid);
+	if (--worker->workers->running == 0)
+		g_main_loop_quit(worker->workers->loop);
+}
+
+
+static gboolean are_tags_files(gchar **files, gint files_count)
+{
+	gint i;
+
+	for (i = 0; i < files_count; i++)
+	{
+		if (! g_str_has_suffix(files[i], ".tags"))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
+/* Parses the files in jobs worker processes (this program started with -g) which
+ * write sorted binary shards, then merges the shards into tags_file.
+ * Each worker gets a contiguous part of the file list so that the merge gives
+ * the same result as parsing all files in one process. The files of a worker
+ * which exits with an error are parsed again in this process.
+ * Returns FALSE if the workers couldn't be started, otherwise sets *status. */
+static gboolean generate_global_tags_parallel(const gchar *prgname, const gchar *tags_file,
+		gchar **files, gint files_count, gint jobs, TMParserType lang, gboolean want_binary,
+		gboolean *status)
+{
+	gchar *tmp_dir = g_dir_make_tmp("geany_tags_XXXXXX", NULL);
+	gchar *basename;
+	TagsWorker *worker_list;
+	TagsWorkers workers;
+	gint i, started = 0, start = 0;
+	gboolean ok = TRUE;
+
+	if (! tmp_dir)
+		return FALSE;
+
+	basename = g_path_get_basename(tags_file);
+	jobs = MIN(jobs, files_count);
+	worker_list = g_new0(TagsWorker, jobs);
+	workers.loop = g_main_loop_new(NULL, FALSE);
+	workers.running = 0;
+
+	for (i = 0; i < jobs && ok; i++)
+	{
+		TagsWorker *worker = &worker_list[i];
+		GPtrArray *args = g_ptr_array_new();
+		GError *error = NULL;
+		GPid pid;
+		gint j;
+
+		worker->workers = &workers;
+		worker->start = start;
+		worker->end = (gint) ((gint64) files_count * (i + 1) / jobs);
+		/* keep the tags file name for the filetype detection of the worker */
+		worker->shard = g_strdup_printf("%s%c%d_%s", tmp_dir, G_DIR_SEPARATOR, i, basename);
+
+		g_ptr_array_add(args, (gpointer) prgname);
+		g_ptr_array_add(args, (gpointer) "-c");
+		g_ptr_array_add(args, app->configdir);
+		g_ptr_array_add(args, (gpointer) "-g");
+		g_ptr_array_add(args, (gpointer) "-P");
+		g_ptr_array_add(args, (gpointer) "--binary-tags");
+		g_ptr_array_add(args, worker->shard);
+		for (j = worker->start; j < worker->end; j++)
+			g_ptr_array_add(args, files[j]);
+		g_ptr_array_add(args, NULL);
+
+		if (g_spawn_async(NULL, (gchar **) args->pdata, NULL,
+				G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_STDOUT_TO_DEV_NULL,
+				NULL, NULL, &pid, &error))
+		{
+			g_child_watch_add(pid, on_tags_worker_exit, worker);
+			workers.running++;
+			started++;
+		}
+		else
+		{
+			g_printerr(_("Failed to start tags worker process: %s\n"), error->message);
+			g_error_free(error);
+			ok = FALSE;
+		}
+		g_ptr_array_free(args, TRUE);
+		start = worker->end;
+	}
+
+	if (workers.running > 0)
+		g_main_loop_run(workers.loop);
+	g_main_loop_unref(workers.loop);
+
+	if (ok)
+	{
+		GPtrArray *written = g_ptr_array_new();
+
+		for (i = 0; i < started; i++)
+		{
+			TagsWorker *worker = &worker_list[i];
+
+			if (worker->failed)
+			{
+				/* don't trust a shard the worker may have left half written */
+				g_unlink(worker->shard);
+				tm_workspace_create_global_tags(NULL, (const gchar **) (files + worker->start),
+					worker->end - worker->start, worker->shard, lang, TRUE);
+			}
+			/* shards without symbols aren't written */
+			if (g_file_test(worker->shard, G_FILE_TEST_EXISTS))
+				g_ptr_array_add(written, worker->shard);
+		}
+		*status = written->len > 0 &&
+			tm_workspace_create_global_tags(NULL, (const gchar **) written->pdata,
+				written->len, tags_file, lang, want_binary);
+		g_ptr_array_free(written, TRUE);
+	}
+
+	for (i = 0; i < jobs; i++)
+	{
+		if (worker_list[i].shard)
+			g_unlink(worker_list[i].shard);
+		g_free(worker_list[i].shard);
+	}
+	g_rmdir(tmp_dir);
+	g_free(worker_list);
+	g_free(basename);
+	g_free(tmp_dir);
+	return ok;
+}
+
+
 /* Adapted from anjuta-2.0.2/global-tags/tm_global_tags.c, thanks.
  * Needs full paths for filenames, except for C/C++ tag files, when CFLAGS includes
  * the relevant path.
  * Example:
  * CFLAGS=-I/home/user/libname-1.x geany -g libname.d.tags libname.h */
-int symbols_generate_global_tags(int argc, char **argv, gboolean want_preprocess)
+int symbols_generate_global_tags(int argc, char **argv, gboolean want_preprocess,
+		gboolean want_binary, gint jobs)
 {
 	/* -E pre-process, -dD output user macros, -p prof info (?) */
 	const char pre_process[] = "gcc -E -dD -p -I.";
@@ -1274,7 +1522,7 @@ int symbols_generate_global_tags(int argc, char **argv, gboolean want_preprocess
 	if (argc > 2)
 	{
 		/* Create global taglist */
-		int status;
+		gboolean status;
 		char *command;
 		const char *tags_file = argv[1];
 		char *utf8_fname;
@@ -1306,8 +1554,14 @@ int symbols_generate_global_tags(int argc, char **argv, gboolean want_preprocess
 
 		geany_debug("Generating %s tags file.", ft->name);
 		tm_get_workspace();
-		status = tm_workspace_create_global_tags(command, (const char **) (argv + 2),
-												 argc - 2, tags_file, ft->lang);
+		/* preprocessing handles all files at once so it cannot be split */
+		if (jobs <= 1 || command != NULL || argc - 2 < 2 || are_tags_files(argv + 2, argc - 2) ||
+			! generate_global_tags_parallel(argv[0], tags_file, argv + 2, argc - 2, jobs,
+				ft->lang, want_binary, &status))
+		{
+			status = tm_workspace_create_global_tags(command, (const char **) (argv + 2),
+													 argc - 2, tags_file, ft->lang, want_binary);
+		}
 		g_free(command);
 		symbols_finalize(); /* free c_tags_ignore data */
 		if (! status)
@@ -1423,7 +1677,7 @@ static void init_user_tags(void)
 }
 
 
-static void load_user_tags(GeanyFiletypeID ft_id)
+static void collect_user_tags(GeanyFiletypeID ft_id, GPtrArray *tags_files, GPtrArray *file_types)
 {
 	static guchar *tags_loaded = NULL;
 	static gboolean init_tags = FALSE;
@@ -1446,9 +1700,8 @@ static void load_user_tags(GeanyFiletypeID ft_id)
 
 	for (node = ft->priv->tag_files; node != NULL; node = g_slist_next(node))
 	{
-		const gchar *fname = node->data;
-
-		symbols_load_global_tags(fname, ft);
+		g_ptr_array_add(tags_files, node->data);
+		g_ptr_array_add(file_types, ft);
 	}
 }
 
@@ -1799,6 +2052,311 @@ gboolean symbols_goto_tag(GeanyDocument *doc, gint pos, gboolean definition)
 }
 
 
+/* maximum number of workspace and of global results */
+#define GOTO_SYMBOL_MAX_RESULTS 200
+
+enum
+{
+	GOTO_SYMBOL_COLUMN_ICON,
+	GOTO_SYMBOL_COLUMN_NAME,
+	GOTO_SYMBOL_COLUMN_LOCATION,
+	GOTO_SYMBOL_COLUMN_TAG,
+	GOTO_SYMBOL_N_COLUMNS
+};
+
+static struct
+{
+	GtkWidget *dialog;
+	GtkWidget *entry;
+	GtkWidget *tree_view;
+	GtkListStore *store;
+	guint query_id;
+	gboolean query_global;  /* whether the next idle query searches the global tags */
+}
+goto_symbol_dialog;
+
+
+static void goto_symbol_clear(void)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL(goto_symbol_dialog.store);
+	GtkTreeIter iter;
+	gboolean valid;
+
+	for (valid = gtk_tree_model_get_iter_first(model, &iter); valid;
+		 valid = gtk_tree_model_iter_next(model, &iter))
+	{
+		TMTag *tag;
+
+		gtk_tree_model_get(model, &iter, GOTO_SYMBOL_COLUMN_TAG, &tag, -1);
+		tm_tag_unref(tag);
+	}
+	gtk_list_store_clear(goto_symbol_dialog.store);
+}
+
+
+static void goto_symbol_append(GPtrArray *tags)
+{
+	gboolean was_empty = gtk_tree_model_iter_n_children(GTK_TREE_MODEL(goto_symbol_dialog.store), NULL) == 0;
+	TMTag *tag;
+	guint i;
+
+	foreach_ptr_array(tag, i, tags)
+	{
+		GtkTreeIter iter;
+		gchar *name, *location;
+
+		if (!EMPTY(tag->scope))
+			name = g_markup_printf_escaped("%s  <small>%s</small>", tag->name, tag->scope);
+		else
+			name = g_markup_escape_text(tag->name, -1);
+
+		if (tag->file)
+			location = g_strdup_printf("%s:%lu", tag->file->short_name, tag->line);
+		else
+			location = g_strdup(_("(global tags)"));
+
+		gtk_list_store_insert_with_values(goto_symbol_dialog.store, &iter, -1,
+			GOTO_SYMBOL_COLUMN_ICON, symbols_get_icon_pixbuf(get_tag_class(tag)),
+			GOTO_SYMBOL_COLUMN_NAME, name,
+			GOTO_SYMBOL_COLUMN_LOCATION, location,
+			GOTO_SYMBOL_COLUMN_TAG, tm_tag_ref(tag),
+			-1);
+		g_free(name);
+		g_free(location);
+	}
+
+	if (was_empty && tags->len > 0)
+	{
+		GtkTreePath *path = gtk_tree_path_new_first();
+
+		gtk_tree_view_set_cursor(GTK_TREE_VIEW(goto_symbol_dialog.tree_view), path, NULL, FALSE);
+		gtk_tree_path_free(path);
+	}
+}
+
+
+/* Searches the workspace tags in the first idle call and the global tags in the
+ * next one, so that the results of the open files show up without waiting for
+ * the (often much bigger) global tags */
+static gboolean goto_symbol_query_idle(gpointer data)
+{
+	const gchar *pattern = gtk_entry_get_text(GTK_ENTRY(goto_symbol_dialog.entry));
+	GPtrArray *tags;
+
+	tags = tm_workspace_find_symbols(pattern, goto_symbol_dialog.query_global, GOTO_SYMBOL_MAX_RESULTS);
+	goto_symbol_append(tags);
+	g_ptr_array_free(tags, TRUE);
+
+	if (!goto_symbol_dialog.query_global)
+	{
+		goto_symbol_dialog.query_global = TRUE;
+		return G_SOURCE_CONTINUE;
+	}
+	goto_symbol_dialog.query_id = 0;
+	return G_SOURCE_REMOVE;
+}
+
+
+static void goto_symbol_cancel_query(void)
+{
+	if (goto_symbol_dialog.query_id != 0)
+	{
+		g_source_remove(goto_symbol_dialog.query_id);
+		goto_symbol_dialog.query_id = 0;
+	}
+}
+
+
+static void on_goto_symbol_entry_changed(GtkEditable *editable, gpointer user_data)
+{
+	goto_symbol_cancel_query();
+	goto_symbol_clear();
+
+	goto_symbol_dialog.query_global = FALSE;
+	goto_symbol_dialog.query_id = g_idle_add(goto_symbol_query_idle, NULL);
+}
+
+
+static void goto_symbol_activate(GtkTreePath *path)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL(goto_symbol_dialog.store);
+	GtkTreeIter iter;
+	TMTag *tag;
+
+	if (!path || !gtk_tree_model_get_iter(model, &iter, path))
+		return;
+
+	gtk_tree_model_get(model, &iter, GOTO_SYMBOL_COLUMN_TAG, &tag, -1);
+	if (!tag->file)
+	{
+		/* global tags don't know where they come from */
+		utils_beep();
+		ui_set_statusbar(FALSE, _("The location of \"%s\" is unknown."), tag->name);
+		return;
+	}
+
+	tag = tm_tag_ref(tag);
+	gtk_widget_hide(goto_symbol_dialog.dialog);
+	on_goto_popup_item_activate(NULL, tag);
+	tm_tag_unref(tag);
+}
+
+
+static void on_goto_symbol_row_activated(GtkTreeView *tree_view, GtkTreePath *path,
+		GtkTreeViewColumn *column, gpointer user_data)
+{
+	goto_symbol_activate(path);
+}
+
+
+static void on_goto_symbol_entry_activate(GtkEntry *entry, gpointer user_data)
+{
+	GtkTreePath *path;
+
+	gtk_tree_view_get_cursor(GTK_TREE_VIEW(goto_symbol_dialog.tree_view), &path, NULL);
+	goto_symbol_activate(path);
+	gtk_tree_path_free(path);
+}
+
+
+/* lets the arrow keys move the selection while the entry has the focus */
+static gboolean on_goto_symbol_entry_key_press(GtkWidget *widget, GdkEventKey *event, gpointer user_data)
+{
+	GtkTreeView *tree_view = GTK_TREE_VIEW(goto_symbol_dialog.tree_view);
+	GtkTreeModel *model = GTK_TREE_MODEL(goto_symbol_dialog.store);
+	gint n_rows = gtk_tree_model_iter_n_children(model, NULL);
+	GtkTreePath *path;
+	gint row = 0;
+
+	if (event->keyval != GDK_KEY_Up && event->keyval != GDK_KEY_Down)
+		return FALSE;
+	if (n_rows == 0)
+		return TRUE;
+
+	gtk_tree_view_get_cursor(tree_view, &path, NULL);
+	if (path)
+	{
+		row = gtk_tree_path_get_indices(path)[0];
+		row += event->keyval == GDK_KEY_Up ? -1 : 1;
+		gtk_tree_path_free(path);
+	}
+	row = CLAMP(row, 0, n_rows - 1);
+
+	path = gtk_tree_path_new_from_indices(row, -1);
+	gtk_tree_view_set_cursor(tree_view, path, NULL, FALSE);
+	gtk_tree_path_free(path);
+	return TRUE;
+}
+
+
+static void on_goto_symbol_dialog_response(GtkDialog *dialog, gint response, gpointer user_data)
+{
+	gtk_widget_hide(GTK_WIDGET(dialog));
+}
+
+
+/* drops the tags when the dialog closes, the files they point to may go away */
+static void on_goto_symbol_dialog_hide(GtkWidget *widget, gpointer user_data)
+{
+	goto_symbol_cancel_query();
+	goto_symbol_clear();
+}
+
+
+static void create_goto_symbol_dialog(void)
+{
+	GtkWidget *vbox, *swin;
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
+
+	goto_symbol_dialog.dialog = gtk_dialog_new_with_buttons(_("Go to Symbol"),
+		GTK_WINDOW(main_widgets.window), GTK_DIALOG_DESTROY_WITH_PARENT,
+		GTK_STOCK_CLOSE, GTK_RESPONSE_CLOSE, NULL);
+	gtk_widget_set_name(goto_symbol_dialog.dialog, "GeanyDialog");
+	gtk_window_set_default_size(GTK_WINDOW(goto_symbol_dialog.dialog), 600, 400);
+	gtk_window_set_modal(GTK_WINDOW(goto_symbol_dialog.dialog), TRUE);
+	vbox = ui_dialog_vbox_new(GTK_DIALOG(goto_symbol_dialog.dialog));
+	gtk_box_set_spacing(GTK_BOX(vbox), 6);
+
+	goto_symbol_dialog.entry = gtk_entry_new();
+	gtk_entry_set_placeholder_text(GTK_ENTRY(goto_symbol_dialog.entry), _("Symbol name"));
+	gtk_box_pack_start(GTK_BOX(vbox), goto_symbol_dialog.entry, FALSE, FALSE, 0);
+
+	goto_symbol_dialog.store = gtk_list_store_new(GOTO_SYMBOL_N_COLUMNS,
+		GDK_TYPE_PIXBUF, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_POINTER);
+	goto_symbol_dialog.tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(goto_symbol_dialog.store));
+	g_object_unref(goto_symbol_dialog.store);
+	gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(goto_symbol_dialog.tree_view), FALSE);
+	gtk_tree_view_set_enable_search(GTK_TREE_VIEW(goto_symbol_dialog.tree_view), FALSE);
+	gtk_widget_set_can_focus(goto_symbol_dialog.tree_view, FALSE);
+
+	column = gtk_tree_view_column_new();
+	renderer = gtk_cell_renderer_pixbuf_new();
+	gtk_tree_view_column_pack_start(column, renderer, FALSE);
+	gtk_tree_view_column_add_attribute(column, renderer, "pixbuf", GOTO_SYMBOL_COLUMN_ICON);
+	renderer = gtk_cell_renderer_text_new();
+	g_object_set(renderer, "ellipsize", PANGO_ELLIPSIZE_END, NULL);
+	gtk_tree_view_column_pack_start(column, renderer, TRUE);
+	gtk_tree_view_column_add_attribute(column, renderer, "markup", GOTO_SYMBOL_COLUMN_NAME);
+	gtk_tree_view_column_set_expand(column, TRUE);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(goto_symbol_dialog.tree_view), column);
+
+	renderer = gtk_cell_renderer_text_new();
+	g_object_set(renderer, "ellipsize", PANGO_ELLIPSIZE_START, "xalign", 1.0, NULL);
+	column = gtk_tree_view_column_new_with_attributes(NULL, renderer,
+		"text", GOTO_SYMBOL_COLUMN_LOCATION, NULL);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(goto_symbol_dialog.tree_view), column);
+
+	swin = gtk_scrolled_window_new(NULL, NULL);
+	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(swin),
+		GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+	gtk_scrolled_window_set_shadow_type(GTK_SCROLLED_WINDOW(swin), GTK_SHADOW_IN);
+	gtk_container_add(GTK_CONTAINER(swin), goto_symbol_dialog.tree_view);
+	gtk_box_pack_start(GTK_BOX(vbox), swin, TRUE, TRUE, 0);
+
+	g_signal_connect(goto_symbol_dialog.entry, "changed",
+		G_CALLBACK(on_goto_symbol_entry_changed), NULL);
+	g_signal_connect(goto_symbol_dialog.entry, "activate",
+		G_CALLBACK(on_goto_symbol_entry_activate), NULL);
+	g_signal_connect(goto_symbol_dialog.entry, "key-press-event",
+		G_CALLBACK(on_goto_symbol_entry_key_press), NULL);
+	g_signal_connect(goto_symbol_dialog.tree_view, "row-activated",
+		G_CALLBACK(on_goto_symbol_row_activated), NULL);
+	g_signal_connect(goto_symbol_dialog.dialog, "response",
+		G_CALLBACK(on_goto_symbol_dialog_response), NULL);
+	g_signal_connect(goto_symbol_dialog.dialog, "hide",
+		G_CALLBACK(on_goto_symbol_dialog_hide), NULL);
+	g_signal_connect(goto_symbol_dialog.dialog, "delete-event",
+		G_CALLBACK(gtk_widget_hide_on_delete), NULL);
+
+	gtk_widget_show_all(vbox);
+}
+
+
+/* Shows a dialog listing the workspace and global symbols matching the typed
+ * text, updated while typing. The selected text is used as the initial text. */
+void symbols_show_goto_symbol_dialog(void)
+{
+	GeanyDocument *doc = document_get_current();
+	gchar *text = NULL;
+
+	if (!goto_symbol_dialog.dialog)
+		create_goto_symbol_dialog();
+
+	if (doc && sci_has_selection(doc->editor->sci))
+		text = sci_get_selection_contents(doc->editor->sci);
+	if (text && !strchr(text, '\n'))
+		gtk_entry_set_text(GTK_ENTRY(goto_symbol_dialog.entry), text);
+	g_free(text);
+	/* the results were dropped when the dialog was hidden */
+	on_goto_symbol_entry_changed(GTK_EDITABLE(goto_symbol_dialog.entry), NULL);
+
+	gtk_editable_select_region(GTK_EDITABLE(goto_symbol_dialog.entry), 0, -1);
+	gtk_widget_grab_focus(goto_symbol_dialog.entry);
+	gtk_window_present(GTK_WINDOW(goto_symbol_dialog.dialog));
+}
+
+
 /* This could perhaps be improved to check for #if, class etc. */
 static gint get_function_fold_number(GeanyDocument *doc)
 {
@@ -2305,6 +2863,15 @@ void symbols_init(void)
 
 	for (i = 0; i < G_N_ELEMENTS(symbols_icons); i++)
 		symbols_icons[i].pixbuf = get_tag_icon(symbols_icons[i].icon_name);
+
+	tm_workspace_set_parse_workers((guint) MAX(editor_prefs.symbol_parse_workers, 0));
+	tm_workspace_set_include_depth((guint) MAX(editor_prefs.autocompletion_include_depth, 1));
+	tm_source_file_set_parse_time_limit((guint) MAX(editor_prefs.symbol_parse_time_limit, 0));
+
+	f = g_build_filename(app->configdir, GEANY_TAGS_CACHE_SUBDIR, NULL);
+	tm_source_file_set_cache_dir(editor_prefs.symbol_cache_size > 0 ? f : NULL,
+		(guint64) MAX(editor_prefs.symbol_cache_size, 0) * 1024 * 1024);
+	g_free(f);
 }
 
 
@@ -2314,6 +2881,10 @@ void symbols_finalize(void)
 
 	g_strfreev(c_tags_ignore);
 
+	if (typename_keywords)
+		g_hash_table_destroy(typename_keywords);
+	typename_keywords = NULL;
+
 	for (i = 0; i < G_N_ELEMENTS(symbols_icons); i++)
 	{
 		if (symbols_icons[i].pixbuf)
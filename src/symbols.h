@@ -52,14 +52,19 @@ void symbols_global_tags_loaded(guint file_type_idx);
 
 GString *symbols_find_typenames_as_string(TMParserType lang, gboolean global);
 
+const gchar *symbols_get_typename_keywords(TMParserType lang, guint *version);
+
 gboolean symbols_recreate_tag_list(GeanyDocument *doc, gint sort_mode);
 
-gint symbols_generate_global_tags(gint argc, gchar **argv, gboolean want_preprocess);
+gint symbols_generate_global_tags(gint argc, gchar **argv, gboolean want_preprocess,
+		gboolean want_binary, gint jobs);
 
 void symbols_show_load_tags_dialog(void);
 
 gboolean symbols_goto_tag(GeanyDocument *doc, gint pos, gboolean definition);
 
+void symbols_show_goto_symbol_dialog(void);
+
 gint symbols_get_current_function(GeanyDocument *doc, const gchar **tagname);
 
 gint symbols_get_current_scope(GeanyDocument *doc, const gchar **tagname);
@@ -16,6 +16,7 @@
 #include "field_p.h"
 #include "options_p.h"
 #include "parse_p.h"
+#include "read_p.h"
 #include "trashbox_p.h"
 #include "writer_p.h"
 #include "xtag_p.h"
@@ -25,9 +26,27 @@
 #include <errno.h>
 
 
+typedef struct
+{
+	TMSourceFile *source_file;
+	GPtrArray *tags_array;  /* where the parsed tags are stored */
+	TMTagArena *arena;  /* where the parsed tags are allocated */
+	gint64 deadline;  /* monotonic time when the parse is interrupted, 0 for none */
+	gint *cancelled;  /* atomic - interrupts the parse when set, can be NULL */
+	gboolean interrupted;  /* whether the parse was stopped early */
+} ParseTarget;
+
+
 static gint write_entry(tagWriter *writer, MIO * mio, const tagEntryInfo *const tag, void *user_data);
 static void rescan_failed(tagWriter *writer, gulong valid_tag_num, void *user_data);
 
+/* ctags keeps its state in global variables so only one parse can run at a time;
+ * parses are started from the background parser threads too */
+static GMutex ctags_mutex;
+static GThread *main_thread = NULL;
+/* the symbols passed to the CPreProcessor "ignore" parameter, protected by ctags_mutex */
+static GString *ignore_symbols = NULL;
+
 tagWriter geanyWriter = {
 	.writeEntry = write_entry,
 	.writePtagEntry = NULL, /* no pseudo-tags */
@@ -41,6 +60,31 @@ tagWriter geanyWriter = {
 };
 
 
+static gboolean log_message_idle(gpointer data)
+{
+	gchar *msg = data;
+
+	g_warning("%s", msg);
+	g_free(msg);
+	return FALSE;
+}
+
+
+/* Logs a warning from any thread; the log handlers aren't thread-safe so
+ * messages from other threads are logged from the main loop. */
+void tm_ctags_log_warning(const gchar *format, ...)
+{
+	va_list ap;
+
+	va_start(ap, format);
+	if (g_thread_self() != main_thread)
+		g_idle_add(log_message_idle, g_strdup_vprintf(format, ap));
+	else
+		g_logv(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, format, ap);
+	va_end(ap);
+}
+
+
 G_GNUC_PRINTF(2, 0)
 static bool nonfatal_error_printer(const errorSelection selection,
 					  const gchar *const format,
@@ -57,7 +101,22 @@ static bool nonfatal_error_printer(const errorSelection selection,
 	else /* use WARNING level by default */
 		lvl_flags = G_LOG_LEVEL_WARNING;
 
-	if (! (selection & PERROR))
+	if (g_thread_self() != main_thread)
+	{
+		/* the log handlers aren't thread-safe - log from the main loop */
+		const gchar *err = (selection & PERROR) ? g_strerror(errno) : NULL;
+		gchar *msg = g_strdup_vprintf(format, ap);
+
+		if (err)
+		{
+			gchar *tmp = msg;
+
+			msg = g_strconcat(tmp, ": ", err, NULL);
+			g_free(tmp);
+		}
+		g_idle_add(log_message_idle, msg);
+	}
+	else if (! (selection & PERROR))
 		g_logv(G_LOG_DOMAIN, lvl_flags, format, ap);
 	else
 	{
@@ -139,7 +198,7 @@ static gboolean init_tag(TMTag *tag, TMSourceFile *file, const tagEntryInfo *tag
 	if (!tag_entry->name || type == tm_tag_undef_t)
 		return FALSE;
 
-	tag->name = g_strdup(tag_entry->name);
+	tag->name = tm_tag_intern_str(tag_entry->name);
 	tag->type = type;
 	tag->local = tag_entry->isFileScope && file->trust_file_scope;
 	tag->flags = tm_tag_flag_none_t;
@@ -148,14 +207,21 @@ static gboolean init_tag(TMTag *tag, TMSourceFile *file, const tagEntryInfo *tag
 	tag->kind_letter = kind_letter;
 	tag->line = tag_entry->lineNumber;
 	if (NULL != tag_entry->extensionFields.signature)
-		tag->arglist = g_strdup(tag_entry->extensionFields.signature);
+		tag->arglist = tm_tag_intern_str(tag_entry->extensionFields.signature);
 	if ((NULL != tag_entry->extensionFields.scopeName) &&
 		(0 != tag_entry->extensionFields.scopeName[0]))
-		tag->scope = g_strdup(tag_entry->extensionFields.scopeName);
+	{
+		gchar *scope = (gchar *) tag_entry->extensionFields.scopeName;
+		gchar *new_scope = tm_parser_update_scope(file->lang, scope);
+
+		tag->scope = tm_tag_intern_str(new_scope);
+		if (new_scope != scope)
+			g_free(new_scope);
+	}
 	if (tag_entry->extensionFields.inheritance != NULL)
-		tag->inheritance = g_strdup(tag_entry->extensionFields.inheritance);
+		tag->inheritance = tm_tag_intern_str(tag_entry->extensionFields.inheritance);
 	if (tag_entry->extensionFields.typeRef[1] != NULL)
-		tag->var_type = g_strdup(tag_entry->extensionFields.typeRef[1]);
+		tag->var_type = tm_tag_intern_str(tag_entry->extensionFields.typeRef[1]);
 	if (tag_entry->extensionFields.access != NULL)
 		tag->access = tm_source_file_get_tag_access(tag_entry->extensionFields.access);
 	if (tag_entry->extensionFields.implementation != NULL)
@@ -166,33 +232,24 @@ static gboolean init_tag(TMTag *tag, TMSourceFile *file, const tagEntryInfo *tag
 	/* redefine lang also for subparsers because the rest of Geany assumes that
 	 * tags from a single file are from a single language */
 	tag->lang = file->lang;
-	if (tag->scope)
-	{
-		gchar *new_scope = tm_parser_update_scope(tag->lang, tag->scope);
-		if (new_scope != tag->scope)
-		{
-			g_free(tag->scope);
-			tag->scope = new_scope;
-		}
-	}
 	return TRUE;
 }
 
 
 static gint write_entry(tagWriter *writer, MIO * mio, const tagEntryInfo *const tag, void *user_data)
 {
-	TMSourceFile *source_file = user_data;
-	TMTag *tm_tag = tm_tag_new();
+	ParseTarget *target = user_data;
+	TMTag *tm_tag = tm_tag_arena_new_tag(target->arena);
 
 	getTagScopeInformation((tagEntryInfo *)tag, NULL, NULL);
 
-	if (!init_tag(tm_tag, source_file, tag))
+	if (!init_tag(tm_tag, target->source_file, tag))
 	{
 		tm_tag_unref(tm_tag);
 		return 0;
 	}
 
-	g_ptr_array_add(source_file->tags_array, tm_tag);
+	g_ptr_array_add(target->tags_array, tm_tag);
 
 	/* output length - we don't write anything to the MIO */
 	return 0;
@@ -201,8 +258,8 @@ static gint write_entry(tagWriter *writer, MIO * mio, const tagEntryInfo *const
 
 static void rescan_failed(tagWriter *writer, gulong valid_tag_num, void *user_data)
 {
-	TMSourceFile *source_file = user_data;
-	GPtrArray *tags_array = source_file->tags_array;
+	ParseTarget *target = user_data;
+	GPtrArray *tags_array = target->tags_array;
 
 	if (tags_array->len > valid_tag_num)
 	{
@@ -214,9 +271,23 @@ static void rescan_failed(tagWriter *writer, gulong valid_tag_num, void *user_da
 }
 
 
+/* called by ctags for every input line */
+static bool parse_interrupted(void *user_data)
+{
+	ParseTarget *target = user_data;
+
+	if ((target->cancelled && g_atomic_int_get(target->cancelled)) ||
+		(target->deadline > 0 && g_get_monotonic_time() > target->deadline))
+		target->interrupted = TRUE;
+	return target->interrupted;
+}
+
+
 /* keep in sync with ctags main() - use only things interesting for us */
 void tm_ctags_init(void)
 {
+	main_thread = g_thread_self();
+
 	initDefaultTrashBox();
 
 	setErrorPrinter(nonfatal_error_printer, NULL);
@@ -251,7 +322,15 @@ void tm_ctags_add_ignore_symbol(const char *value)
 	 * the ignore list in ctags */
 	val = g_strstrip(val);
 	if (*val)
+	{
+		g_mutex_lock(&ctags_mutex);
 		applyParameter (lang, "ignore", val);
+		if (!ignore_symbols)
+			ignore_symbols = g_string_new(NULL);
+		g_string_append(ignore_symbols, val);
+		g_string_append_c(ignore_symbols, '\n');
+		g_mutex_unlock(&ctags_mutex);
+	}
 	g_free(val);
 }
 
@@ -259,7 +338,27 @@ void tm_ctags_add_ignore_symbol(const char *value)
 void tm_ctags_clear_ignore_symbols(void)
 {
 	langType lang = getNamedLanguage ("CPreProcessor", 0);
+
+	g_mutex_lock(&ctags_mutex);
 	applyParameter (lang, "ignore", NULL);
+	if (ignore_symbols)
+		g_string_truncate(ignore_symbols, 0);
+	g_mutex_unlock(&ctags_mutex);
+}
+
+
+/* Returns a newly allocated checksum of the current ignore list, which changes
+ * the tags generated by the parsers using the C preprocessor. */
+gchar *tm_ctags_get_ignore_symbols_hash(void)
+{
+	gchar *hash;
+
+	g_mutex_lock(&ctags_mutex);
+	hash = g_compute_checksum_for_string(G_CHECKSUM_MD5,
+		ignore_symbols ? ignore_symbols->str : "", -1);
+	g_mutex_unlock(&ctags_mutex);
+
+	return hash;
 }
 
 
@@ -279,8 +378,9 @@ static gboolean replace_str(gchar **where, const gchar *what, guint what_len,
 			strncpy(str, *where, prefix_len);
 			strcpy(str + prefix_len, replacement);
 			strcpy(str + prefix_len + replacement_len, pos + what_len);
-			g_free(*where);
-			*where = str;
+			tm_tag_release_str(*where);
+			*where = tm_tag_intern_str(str);
+			g_free(str);
 
 			return TRUE;
 		}
@@ -292,16 +392,16 @@ static gboolean replace_str(gchar **where, const gchar *what, guint what_len,
 
 /* call after all tags have been collected so we don't have to handle reparses
  * with the counter (which gets complicated when also subparsers are involved) */
-static void rename_anon_tags(TMSourceFile *source_file)
+static void rename_anon_tags(TMParserType lang, GPtrArray *tags_array)
 {
-	gboolean is_c = source_file->lang == TM_PARSER_C || source_file->lang == TM_PARSER_CPP;
+	gboolean is_c = lang == TM_PARSER_C || lang == TM_PARSER_CPP;
 	gint *anon_counter_table = NULL;
 	GPtrArray *removed_typedefs = NULL;
 	guint i;
 
-	for (i = 0; i < source_file->tags_array->len; i++)
+	for (i = 0; i < tags_array->len; i++)
 	{
-		TMTag *tag = TM_TAG(source_file->tags_array->pdata[i]);
+		TMTag *tag = TM_TAG(tags_array->pdata[i]);
 		if (tm_tag_is_anon(tag))
 		{
 			gchar *orig_name, *new_name = NULL;
@@ -319,9 +419,9 @@ static void rename_anon_tags(TMSourceFile *source_file)
 				/* First check if there's a typedef behind the scope nesting
 				 * such as typedef struct {} Foo; - in this case we can replace
 				 * the anon tag with Foo */
-				for (j = i + 1; j < source_file->tags_array->len; j++)
+				for (j = i + 1; j < tags_array->len; j++)
 				{
-					TMTag *nested_tag = TM_TAG(source_file->tags_array->pdata[j]);
+					TMTag *nested_tag = TM_TAG(tags_array->pdata[j]);
 					gsize nested_scope_len = nested_tag->scope ? strlen(nested_tag->scope) : 0;
 
 					/* Tags can be interleaved with scopeless macros - skip those */
@@ -336,9 +436,9 @@ static void rename_anon_tags(TMSourceFile *source_file)
 				}
 
 				/* We are out of the nesting - the next tag could be a typedef */
-				if (j < source_file->tags_array->len)
+				if (j < tags_array->len)
 				{
-					TMTag *typedef_tag = TM_TAG(source_file->tags_array->pdata[j]);
+					TMTag *typedef_tag = TM_TAG(tags_array->pdata[j]);
 					gsize typedef_scope_len = typedef_tag->scope ? strlen(typedef_tag->scope) : 0;
 
 					/* Should be at the same scope level as the anon tag */
@@ -348,7 +448,7 @@ static void rename_anon_tags(TMSourceFile *source_file)
 					{
 						/* set the name of the original anon tag and pretend
 						 * it wasn't a anon tag */
-						tag->name = g_strdup(typedef_tag->name);
+						tag->name = tm_tag_intern_str(typedef_tag->name);
 						tag->flags &= ~tm_tag_flag_anon_t;
 						new_name = tag->name;
 						/* the typedef tag will be removed */
@@ -372,7 +472,7 @@ static void rename_anon_tags(TMSourceFile *source_file)
 				anon_counter = ++anon_counter_table[(guchar) kind];
 
 				sprintf(buf, "anon_%s_%u", kind_name, anon_counter);
-				tag->name = g_strdup(buf);
+				tag->name = tm_tag_intern_str(buf);
 				new_name = tag->name;
 			}
 
@@ -381,9 +481,9 @@ static void rename_anon_tags(TMSourceFile *source_file)
 			/* Check if this tag is parent of some other tag - if so, we have to
 			 * update the scope. It can only be parent of the following tags
 			 * so start with the next tag. */
-			for (j = i + 1; j < source_file->tags_array->len; j++)
+			for (j = i + 1; j < tags_array->len; j++)
 			{
-				TMTag *nested_tag = TM_TAG(source_file->tags_array->pdata[j]);
+				TMTag *nested_tag = TM_TAG(tags_array->pdata[j]);
 				gsize nested_scope_len = nested_tag->scope ? strlen(nested_tag->scope) : 0;
 
 				/* Tags can be interleaved with scopeless macros - skip those */
@@ -399,7 +499,7 @@ static void rename_anon_tags(TMSourceFile *source_file)
 				 * we need to skip past the tags on the same scope and only
 				 * afterwards we get the nested tags.
 				 * */
-				if (source_file->lang == TM_PARSER_FORTRAN &&
+				if (lang == TM_PARSER_FORTRAN &&
 					!inside_nesting && nested_scope_len == scope_len)
 					continue;
 
@@ -421,9 +521,9 @@ static void rename_anon_tags(TMSourceFile *source_file)
 
 			/* We are out of the nesting - the next tags could be variables
 			 * of an anonymous struct such as "struct {} a[2], *b, c;" */
-			while (j < source_file->tags_array->len)
+			while (j < tags_array->len)
 			{
-				TMTag *var_tag = TM_TAG(source_file->tags_array->pdata[j]);
+				TMTag *var_tag = TM_TAG(tags_array->pdata[j]);
 				gsize var_scope_len = var_tag->scope ? strlen(var_tag->scope) : 0;
 
 				/* Should be at the same scope level as the anon tag */
@@ -436,7 +536,7 @@ static void rename_anon_tags(TMSourceFile *source_file)
 				j++;
 			}
 
-			g_free(orig_name);
+			tm_tag_release_str(orig_name);
 		}
 	}
 
@@ -445,13 +545,13 @@ static void rename_anon_tags(TMSourceFile *source_file)
 		for (i = 0; i < removed_typedefs->len; i++)
 		{
 			guint j = GPOINTER_TO_UINT(removed_typedefs->pdata[i]);
-			TMTag *tag = TM_TAG(source_file->tags_array->pdata[j]);
+			TMTag *tag = TM_TAG(tags_array->pdata[j]);
 			tm_tag_unref(tag);
-			source_file->tags_array->pdata[j] = NULL;
+			tags_array->pdata[j] = NULL;
 		}
 
 		/* remove NULL entries from the array */
-		tm_tags_prune(source_file->tags_array);
+		tm_tags_prune(tags_array);
 
 		g_ptr_array_free(removed_typedefs, TRUE);
 	}
@@ -461,17 +561,37 @@ static void rename_anon_tags(TMSourceFile *source_file)
 }
 
 
-void tm_ctags_parse(guchar *buffer, gsize buffer_size,
-	const gchar *file_name, TMParserType language, TMSourceFile *source_file)
+/* Parses buffer (or file_name when buffer is NULL) and appends the resulting tags
+ * belonging to source_file to tags_array. Can be called from any thread.
+ * The parse stops early when it takes longer than time_limit microseconds
+ * (0 for no limit) or when cancelled is set. Returns TRUE when the parse was
+ * stopped early and tags_array only contains the tags found until then. */
+gboolean tm_ctags_parse(guchar *buffer, gsize buffer_size,
+	const gchar *file_name, TMParserType language, TMSourceFile *source_file,
+	GPtrArray *tags_array, gint64 time_limit, gint *cancelled)
 {
-	g_return_if_fail(buffer != NULL || file_name != NULL);
+	ParseTarget target = {source_file, tags_array, NULL, 0, cancelled, FALSE};
 
-	if (language == TM_PARSER_NONE)
-		return;
+	g_return_val_if_fail(buffer != NULL || file_name != NULL, FALSE);
 
-	parseRawBuffer(file_name, buffer, buffer_size, language, source_file);
+	if (language == TM_PARSER_NONE)
+		return FALSE;
 
-	rename_anon_tags(source_file);
+	/* the tags of a file are usually all freed together on the next parse */
+	target.arena = tm_tag_arena_new();
+	g_mutex_lock(&ctags_mutex);
+	/* waiting for the mutex doesn't count */
+	if (time_limit > 0)
+		target.deadline = g_get_monotonic_time() + time_limit;
+	setInputInterruptCheck(parse_interrupted, &target);
+	parseRawBuffer(file_name, buffer, buffer_size, language, &target);
+	/* don't ask isInputInterrupted(), it would check again after the parse ended */
+	setInputInterruptCheck(NULL, NULL);
+	g_mutex_unlock(&ctags_mutex);
+	tm_tag_arena_free(target.arena);
+
+	rename_anon_tags(source_file->lang, tags_array);
+	return target.interrupted;
 }
 
 
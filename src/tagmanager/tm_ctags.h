@@ -20,8 +20,11 @@ G_BEGIN_DECLS
 void tm_ctags_init(void);
 void tm_ctags_add_ignore_symbol(const char *value);
 void tm_ctags_clear_ignore_symbols(void);
-void tm_ctags_parse(guchar *buffer, gsize buffer_size,
-	const gchar *file_name, TMParserType language, TMSourceFile *source_file);
+gchar *tm_ctags_get_ignore_symbols_hash(void);
+void tm_ctags_log_warning(const gchar *format, ...) G_GNUC_PRINTF(1, 2);
+gboolean tm_ctags_parse(guchar *buffer, gsize buffer_size,
+	const gchar *file_name, TMParserType language, TMSourceFile *source_file,
+	GPtrArray *tags_array, gint64 time_limit, gint *cancelled);
 const gchar *tm_ctags_get_lang_name(TMParserType lang);
 TMParserType tm_ctags_get_named_lang(const gchar *name);
 const gchar *tm_ctags_get_lang_kinds(TMParserType lang);
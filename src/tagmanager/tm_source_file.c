@@ -14,6 +14,9 @@
  tags for individual files.
 */
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
 
 #include <stdio.h>
 #include <limits.h>
@@ -40,6 +43,10 @@ typedef struct
 {
 	TMSourceFile public;
 	guint refcount;
+	TMSourceFileIncludes includes;
+	gint parse_time;
+	gint overruns; /* number of consecutive parses which exceeded parse_time_limit */
+	GArray *refs; /* sorted hashes of the words of the file, see tm_source_file_set_refs() */
 } TMSourceFilePriv;
 
 
@@ -71,6 +78,75 @@ enum
 };
 
 
+/* Binary global tags file layout (all integers little-endian):
+ * BinaryTagsHeader, tag_count BinaryTag records sorted by the global tags sort
+ * attributes, then a table of NUL-terminated strings referenced by offset.
+ * The file is mapped and the loaded tags point directly into the string table. */
+#define BINARY_TAGS_MAGIC "GeanyTM"
+#define BINARY_TAGS_VERSION 1
+#define BINARY_TAGS_NO_STRING G_MAXUINT32
+
+typedef struct
+{
+	gchar magic[8];
+	guint32 version;
+	guint32 tag_count;
+	guint32 strings_offset;
+	guint32 strings_size;
+} BinaryTagsHeader;
+
+typedef struct
+{
+	guint32 name;
+	guint32 arglist;
+	guint32 scope;
+	guint32 inheritance;
+	guint32 var_type;
+	guint32 type;
+	guint32 line;
+	guint32 flags;
+	guint8 local;
+	gchar access;
+	gchar impl;
+	gchar kind_letter;
+} BinaryTag;
+
+/* Keeps a mapped binary tags file alive together with the tags pointing into it */
+typedef struct
+{
+	GMappedFile *map;
+	TMTag *tags;
+} BinaryTagsFile;
+
+static GSList *binary_tags_files = NULL;
+/* global tags files can be read in parallel */
+static GMutex binary_tags_mutex;
+
+
+/* Increment when the tag cache format changes; the tags generated by the parsers
+ * are covered by the Geany version and the ignore list hash stored in the header */
+#define TAG_CACHE_VERSION 2
+#define TAG_CACHE_ATTRS (tm_tag_attr_type_t | tm_tag_attr_arglist_t | tm_tag_attr_line_t | \
+	tm_tag_attr_local_t | tm_tag_attr_scope_t | tm_tag_attr_inheritance_t | \
+	tm_tag_attr_flags_t | tm_tag_attr_vartype_t | tm_tag_attr_access_t | tm_tag_attr_impl_t)
+
+typedef struct
+{
+	gchar *path;
+	gint64 mtime;
+	guint64 size;
+} CacheFileInfo;
+
+/* the tag cache is used from the parser threads too */
+static GMutex cache_mutex;
+static gchar *cache_dir = NULL;
+static guint64 cache_max_size = 0;
+static guint64 cache_size = 0;
+
+/* in microseconds, 0 for no limit */
+static gint64 parse_time_limit = 0;
+
+
 #define SOURCE_FILE_NEW(S) ((S) = g_slice_new(TMSourceFilePriv))
 #define SOURCE_FILE_FREE(S) g_slice_free(TMSourceFilePriv, (TMSourceFilePriv *) S)
 
@@ -170,22 +246,21 @@ gchar tm_source_file_get_tag_access(const gchar *access)
 }
 
 /*
- Initializes an already malloc()ed TMTag structure by reading a tag entry
- line from a file. The structure should be allocated beforehand.
+ Initializes an already malloc()ed TMTag structure from a tag entry line
+ (without the trailing newline). The structure should be allocated beforehand.
  @param tag The TMTag structure to populate
  @param file The TMSourceFile struct (assigned to the file member)
- @param fp FILE pointer from where the tag line is read
+ @param buf The tag line; it is temporarily modified during parsing
  @return TRUE on success, FALSE on FAILURE
 */
-static gboolean init_tag_from_file(TMTag *tag, TMSourceFile *file, FILE *fp, TMParserType lang)
+static gboolean init_tag_from_line(TMTag *tag, TMSourceFile *file, guchar *buf, TMParserType lang)
 {
-	guchar buf[BUFSIZ];
 	guchar *start, *end;
 	gboolean status;
 	guchar changed_char = TA_NAME;
 
 	tag->refcount = 1;
-	if ((NULL == fgets((gchar*)buf, BUFSIZ, fp)) || ('\0' == *buf))
+	if ('\0' == *buf)
 		return FALSE;
 	for (start = end = buf, status = TRUE; (TRUE == status); start = end, ++ end)
 	{
@@ -201,7 +276,7 @@ static gboolean init_tag_from_file(TMTag *tag, TMSourceFile *file, FILE *fp, TMP
 				return FALSE;
 			else
 			{
-				tag->name = g_strdup((gchar*)start);
+				tag->name = tm_tag_intern_str((gchar*)start);
 				if (tm_parser_is_anon_name(lang, tag->name))
 					tag->flags |= tm_tag_flag_anon_t;
 			}
@@ -220,19 +295,19 @@ static gboolean init_tag_from_file(TMTag *tag, TMSourceFile *file, FILE *fp, TMP
 					tag->type = (TMTagType) atoi((gchar*)start + 1);
 					break;
 				case TA_ARGLIST:
-					tag->arglist = g_strdup((gchar*)start + 1);
+					tag->arglist = tm_tag_intern_str((gchar*)start + 1);
 					break;
 				case TA_SCOPE:
-					tag->scope = g_strdup((gchar*)start + 1);
+					tag->scope = tm_tag_intern_str((gchar*)start + 1);
 					break;
 				case TA_FLAGS:
 					tag->flags |= atoi((gchar*)start + 1);
 					break;
 				case TA_VARTYPE:
-					tag->var_type = g_strdup((gchar*)start + 1);
+					tag->var_type = tm_tag_intern_str((gchar*)start + 1);
 					break;
 				case TA_INHERITS:
-					tag->inheritance = g_strdup((gchar*)start + 1);
+					tag->inheritance = tm_tag_intern_str((gchar*)start + 1);
 					break;
 				case TA_TIME:  /* Obsolete */
 					break;
@@ -261,6 +336,16 @@ static gboolean init_tag_from_file(TMTag *tag, TMSourceFile *file, FILE *fp, TMP
 	return TRUE;
 }
 
+/* Like init_tag_from_line() but reads the line from fp */
+static gboolean init_tag_from_file(TMTag *tag, TMSourceFile *file, FILE *fp, TMParserType lang)
+{
+	guchar buf[BUFSIZ];
+
+	if (NULL == fgets((gchar*)buf, BUFSIZ, fp))
+		return FALSE;
+	return init_tag_from_line(tag, file, buf, lang);
+}
+
 /* alternative parser for Pascal and LaTeX global tags files with the following format
  * tagname|return value|arglist|description\n */
 static gboolean init_tag_from_file_alt(TMTag *tag, TMSourceFile *file, FILE *fp)
@@ -290,10 +375,10 @@ static gboolean init_tag_from_file_alt(TMTag *tag, TMSourceFile *file, FILE *fp)
 			fields = g_strsplit((gchar*)start, "|", -1);
 			field_len = g_strv_length(fields);
 
-			if (field_len >= 1) tag->name = g_strdup(fields[0]);
+			if (field_len >= 1) tag->name = tm_tag_intern_str(fields[0]);
 			else tag->name = NULL;
-			if (field_len >= 2 && fields[1] != NULL) tag->var_type = g_strdup(fields[1]);
-			if (field_len >= 3 && fields[2] != NULL) tag->arglist = g_strdup(fields[2]);
+			if (field_len >= 2 && fields[1] != NULL) tag->var_type = tm_tag_intern_str(fields[1]);
+			if (field_len >= 3 && fields[2] != NULL) tag->arglist = tm_tag_intern_str(fields[2]);
 			tag->type = tm_tag_prototype_t;
 			g_strfreev(fields);
 		}
@@ -306,7 +391,8 @@ static gboolean init_tag_from_file_alt(TMTag *tag, TMSourceFile *file, FILE *fp)
 }
 
 
-static void read_ctags_file(const gchar *tags_file, TMParserType lang, GPtrArray *file_tags)
+static void read_ctags_file(const gchar *tags_file, TMParserType lang, GPtrArray *file_tags,
+	TMTagArena *arena)
 {
 	tagEntry entry;
 	tagFile *f = tagsOpen(tags_file, NULL);
@@ -329,9 +415,8 @@ static void read_ctags_file(const gchar *tags_file, TMParserType lang, GPtrArray
 		if (type == tm_tag_undef_t)
 			continue;
 
-		tag = tm_tag_new();
-		tag->refcount = 1;
-		tag->name = g_strdup(entry.name);
+		tag = tm_tag_arena_new_tag(arena);
+		tag->name = tm_tag_intern_str(entry.name);
 		tag->type = type;
 		tag->lang = lang;
 		tag->local = entry.fileScope;  /* 'f' field */
@@ -352,19 +437,19 @@ static void read_ctags_file(const gchar *tags_file, TMParserType lang, GPtrArray
 				const gchar *val = strchr(value, ':');
 				if (val && *(++val))
 				{
-					g_free(tag->scope);
-					tag->scope = g_strdup(val);
+					tm_tag_release_str(tag->scope);
+					tag->scope = tm_tag_intern_str(val);
 				}
 			}
 			else if (strcmp(key, "signature") == 0)  /* 'S' field */
 			{
-				g_free(tag->arglist);
-				tag->arglist = g_strdup(value);
+				tm_tag_release_str(tag->arglist);
+				tag->arglist = tm_tag_intern_str(value);
 			}
 			else if (strcmp(key, "inherits") == 0)  /* 'i' field */
 			{
-				g_free(tag->inheritance);
-				tag->inheritance = g_strdup(value);
+				tm_tag_release_str(tag->inheritance);
+				tag->inheritance = tm_tag_intern_str(value);
 			}
 			else if (strcmp(key, "typeref") == 0)  /* 't' field */
 			{
@@ -374,8 +459,8 @@ static void read_ctags_file(const gchar *tags_file, TMParserType lang, GPtrArray
 					(g_str_has_prefix(value, "typename:") || g_str_has_prefix(value, "unknown:")))
 				{
 					/* "unknown:" above is used by the php parser, all other parsers use "typename:" */
-					g_free(tag->var_type);
-					tag->var_type = g_strdup(val);
+					tm_tag_release_str(tag->var_type);
+					tag->var_type = tm_tag_intern_str(val);
 				}
 			}
 			else if (strcmp(key, "extras") == 0)  /* 'E' field */
@@ -416,7 +501,7 @@ static void read_ctags_file(const gchar *tags_file, TMParserType lang, GPtrArray
 					if (strcmp(key, name) == 0)
 					{
 						/* 's' field - scope without the 'scope:' prefix */
-						tag->scope = g_strdup(value);
+						tag->scope = tm_tag_intern_str(value);
 						break;
 					}
 				}
@@ -432,9 +517,10 @@ static void read_ctags_file(const gchar *tags_file, TMParserType lang, GPtrArray
 }
 
 
-static TMTag *new_tag_from_tags_file(TMSourceFile *file, FILE *fp, TMParserType mode, TMFileFormat format)
+static TMTag *new_tag_from_tags_file(TMSourceFile *file, FILE *fp, TMParserType mode,
+	TMFileFormat format, TMTagArena *arena)
 {
-	TMTag *tag = tm_tag_new();
+	TMTag *tag = tm_tag_arena_new_tag(arena);
 	gboolean result = FALSE;
 
 	switch (format)
@@ -460,50 +546,224 @@ static TMTag *new_tag_from_tags_file(TMSourceFile *file, FILE *fp, TMParserType
 }
 
 /*
- Writes tag information to the given FILE *.
+ Appends tag information in the tagmanager format to the given string.
  @param tag The tag information to write.
- @param file FILE pointer to which the tag information is written.
+ @param str The string to which the tag information is appended.
  @param attrs Attributes to be written (bitmask).
- @return TRUE on success, FALSE on failure.
 */
-static gboolean write_tag(TMTag *tag, FILE *fp, TMTagAttrType attrs)
+static void append_tag(TMTag *tag, GString *str, TMTagAttrType attrs)
 {
-	fprintf(fp, "%s", tag->name);
+	g_string_append(str, tag->name);
 	if (attrs & tm_tag_attr_type_t)
-		fprintf(fp, "%c%d", TA_TYPE, tag->type);
+		g_string_append_printf(str, "%c%d", TA_TYPE, tag->type);
 	if ((attrs & tm_tag_attr_arglist_t) && (NULL != tag->arglist))
-		fprintf(fp, "%c%s", TA_ARGLIST, tag->arglist);
+		g_string_append_printf(str, "%c%s", TA_ARGLIST, tag->arglist);
 	if (attrs & tm_tag_attr_line_t)
-		fprintf(fp, "%c%ld", TA_LINE, tag->line);
+		g_string_append_printf(str, "%c%ld", TA_LINE, tag->line);
 	if (attrs & tm_tag_attr_local_t)
-		fprintf(fp, "%c%d", TA_LOCAL, tag->local);
+		g_string_append_printf(str, "%c%d", TA_LOCAL, tag->local);
 	if ((attrs & tm_tag_attr_scope_t) && (NULL != tag->scope))
-		fprintf(fp, "%c%s", TA_SCOPE, tag->scope);
+		g_string_append_printf(str, "%c%s", TA_SCOPE, tag->scope);
 	if ((attrs & tm_tag_attr_inheritance_t) && (NULL != tag->inheritance))
-		fprintf(fp, "%c%s", TA_INHERITS, tag->inheritance);
+		g_string_append_printf(str, "%c%s", TA_INHERITS, tag->inheritance);
 	if (attrs & tm_tag_attr_flags_t)
-		fprintf(fp, "%c%d", TA_FLAGS, tag->flags);
+		g_string_append_printf(str, "%c%d", TA_FLAGS, tag->flags);
 	if ((attrs & tm_tag_attr_vartype_t) && (NULL != tag->var_type))
-		fprintf(fp, "%c%s", TA_VARTYPE, tag->var_type);
-	if ((attrs & tm_tag_attr_access_t) && (TAG_ACCESS_UNKNOWN != tag->access))
-		fprintf(fp, "%c%c", TA_ACCESS, tag->access);
-	if ((attrs & tm_tag_attr_impl_t) && (TAG_IMPL_UNKNOWN != tag->impl))
-		fprintf(fp, "%c%c", TA_IMPL, tag->impl);
+		g_string_append_printf(str, "%c%s", TA_VARTYPE, tag->var_type);
+	if ((attrs & tm_tag_attr_access_t) && tag->access && (TAG_ACCESS_UNKNOWN != tag->access))
+		g_string_append_printf(str, "%c%c", TA_ACCESS, tag->access);
+	if ((attrs & tm_tag_attr_impl_t) && tag->impl && (TAG_IMPL_UNKNOWN != tag->impl))
+		g_string_append_printf(str, "%c%c", TA_IMPL, tag->impl);
+	g_string_append_c(str, '\n');
+}
 
-	if (fprintf(fp, "\n"))
-		return TRUE;
-	else
-		return FALSE;
+/*
+ Writes tag information to the given FILE *.
+ @param tag The tag information to write.
+ @param file FILE pointer to which the tag information is written.
+ @param attrs Attributes to be written (bitmask).
+ @return TRUE on success, FALSE on failure.
+*/
+static gboolean write_tag(TMTag *tag, FILE *fp, TMTagAttrType attrs)
+{
+	GString *str = g_string_sized_new(128);
+	gboolean ret;
+
+	append_tag(tag, str, attrs);
+	ret = fwrite(str->str, str->len, 1, fp) == 1;
+	g_string_free(str, TRUE);
+
+	return ret;
+}
+
+static const gchar *get_binary_string(const gchar *strings, guint32 strings_size,
+	guint32 offset, gboolean *valid)
+{
+	offset = GUINT32_FROM_LE(offset);
+	if (offset == BINARY_TAGS_NO_STRING)
+		return NULL;
+	if (offset >= strings_size)
+	{
+		*valid = FALSE;
+		return NULL;
+	}
+	return strings + offset;
+}
+
+/* Reads a tags file in the binary format. The tags are allocated in a single
+ * block and their strings point into the mapped file, so they are marked as
+ * mapped and only freed by tm_source_file_free_binary_tags().
+ * Can run in any thread, so errors are returned instead of logged. */
+static GPtrArray *read_binary_tags_file(const gchar *tags_file, TMParserType mode,
+	GError **error)
+{
+	GMappedFile *map;
+	const BinaryTagsHeader *header;
+	const BinaryTag *records;
+	const gchar *contents, *strings;
+	gsize len;
+	guint32 tag_count, strings_offset, strings_size, i;
+	BinaryTagsFile *binary_file;
+	GPtrArray *file_tags;
+	GError *map_error = NULL;
+	gboolean valid = TRUE;
+
+	map = g_mapped_file_new(tags_file, FALSE, &map_error);
+	if (!map)
+	{
+		g_set_error(error, G_FILE_ERROR, map_error->code, "Failed to map tags file %s: %s",
+			tags_file, map_error->message);
+		g_error_free(map_error);
+		return NULL;
+	}
+	contents = g_mapped_file_get_contents(map);
+	len = g_mapped_file_get_length(map);
+	if (len < sizeof(BinaryTagsHeader))
+		goto invalid;
+
+	header = (const BinaryTagsHeader *) contents;
+	if (GUINT32_FROM_LE(header->version) != BINARY_TAGS_VERSION)
+	{
+		g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+			"Unsupported binary tags file version in %s, please regenerate it", tags_file);
+		g_mapped_file_unref(map);
+		return NULL;
+	}
+	tag_count = GUINT32_FROM_LE(header->tag_count);
+	strings_offset = GUINT32_FROM_LE(header->strings_offset);
+	strings_size = GUINT32_FROM_LE(header->strings_size);
+	if (strings_offset < sizeof(BinaryTagsHeader) ||
+		(strings_offset - sizeof(BinaryTagsHeader)) / sizeof(BinaryTag) < tag_count ||
+		strings_offset > len || len - strings_offset < strings_size ||
+		(strings_size > 0 && contents[strings_offset + strings_size - 1] != '\0'))
+		goto invalid;
+
+	records = (const BinaryTag *) (contents + sizeof(BinaryTagsHeader));
+	strings = contents + strings_offset;
+
+	binary_file = g_new(BinaryTagsFile, 1);
+	binary_file->map = map;
+	binary_file->tags = g_new0(TMTag, tag_count);
+	file_tags = g_ptr_array_sized_new(tag_count);
+	for (i = 0; i < tag_count && valid; i++)
+	{
+		const BinaryTag *record = &records[i];
+		TMTag *tag = &binary_file->tags[i];
+
+		/* the tag strings live in the read-only mapping, they must never be freed
+		 * or modified, so tm_tag_unref() leaves mapped tags alone */
+		tag->refcount = 1;
+		tag->mapped = TRUE;
+		tag->name = (gchar *) get_binary_string(strings, strings_size, record->name, &valid);
+		tag->arglist = (gchar *) get_binary_string(strings, strings_size, record->arglist, &valid);
+		tag->scope = (gchar *) get_binary_string(strings, strings_size, record->scope, &valid);
+		tag->inheritance = (gchar *) get_binary_string(strings, strings_size, record->inheritance, &valid);
+		tag->var_type = (gchar *) get_binary_string(strings, strings_size, record->var_type, &valid);
+		tag->type = GUINT32_FROM_LE(record->type);
+		tag->line = GUINT32_FROM_LE(record->line);
+		tag->flags = GUINT32_FROM_LE(record->flags);
+		tag->local = record->local;
+		tag->access = record->access;
+		tag->impl = record->impl;
+		tag->kind_letter = record->kind_letter;
+		tag->lang = mode;
+		valid = valid && tag->name != NULL;
+		g_ptr_array_add(file_tags, tag);
+	}
+
+	if (!valid)
+	{
+		g_ptr_array_free(file_tags, TRUE);
+		g_free(binary_file->tags);
+		g_free(binary_file);
+		goto invalid;
+	}
+
+	g_mutex_lock(&binary_tags_mutex);
+	binary_tags_files = g_slist_prepend(binary_tags_files, binary_file);
+	g_mutex_unlock(&binary_tags_mutex);
+	return file_tags;
+
+invalid:
+	g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Invalid binary tags file %s", tags_file);
+	g_mapped_file_unref(map);
+	return NULL;
 }
 
-GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mode)
+/* Frees the storage of all loaded binary tags files. Only call this when none
+ * of their tags are used anymore. */
+void tm_source_file_free_binary_tags(void)
+{
+	GSList *node;
+
+	for (node = binary_tags_files; node; node = node->next)
+	{
+		BinaryTagsFile *binary_file = node->data;
+
+		g_free(binary_file->tags);
+		g_mapped_file_unref(binary_file->map);
+		g_free(binary_file);
+	}
+	g_slist_free(binary_tags_files);
+	binary_tags_files = NULL;
+}
+
+/*
+ Reads a global tags file in any of the supported formats.
+ @param tags_file The tags file to read.
+ @param mode The language of the tags.
+ @param sorted Location to store whether the returned tags are already sorted
+ and deduplicated by the global tags sort attributes (binary format), or NULL.
+ @param error Location to store the reason why an invalid binary tags file could
+ not be read, or NULL. Can be set on failure only, and is not set for text files.
+ @return The tags, or NULL on failure.
+*/
+GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mode,
+	gboolean *sorted, GError **error)
 {
 	guchar buf[BUFSIZ];
 	FILE *fp;
 	GPtrArray *file_tags;
+	TMTagArena *arena;
 	TMTag *tag;
 	TMFileFormat format = TM_FILE_FORMAT_TAGMANAGER;
 
+	if (sorted)
+		*sorted = FALSE;
+	if (NULL == (fp = g_fopen(tags_file, "rb")))
+		return NULL;
+	if (fread(buf, 1, sizeof(BINARY_TAGS_MAGIC), fp) == sizeof(BINARY_TAGS_MAGIC) &&
+		memcmp(buf, BINARY_TAGS_MAGIC, sizeof(BINARY_TAGS_MAGIC)) == 0)
+	{
+		fclose(fp);
+		file_tags = read_binary_tags_file(tags_file, mode, error);
+		if (file_tags && sorted)
+			*sorted = TRUE;
+		return file_tags;
+	}
+	fclose(fp);
+
+	/* text formats are read in text mode */
 	if (NULL == (fp = g_fopen(tags_file, "r")))
 		return NULL;
 	if ((NULL == fgets((gchar*) buf, BUFSIZ, fp)) || ('\0' == *buf))
@@ -520,7 +780,9 @@ GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mo
 		else if (buf[0] == '#' && strstr((gchar*) buf, "format=ctags") != NULL)
 		{
 			format = TM_FILE_FORMAT_CTAGS;
-			g_warning("# format=ctags directive is no longer supported; please remove it from %s", tags_file);
+			/* this can run in the tags loading threads */
+			tm_ctags_log_warning("# format=ctags directive is no longer supported; please remove it from %s",
+				tags_file);
 		}
 		else if (strncmp((gchar*) buf, "!_TAG_", 6) == 0)
 			format = TM_FILE_FORMAT_CTAGS;
@@ -546,17 +808,19 @@ GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mo
 	}
 
 	file_tags = g_ptr_array_new();
+	arena = tm_tag_arena_new();
 	if (format == TM_FILE_FORMAT_CTAGS)
 	{
 		fclose(fp);  /* the readtags library opens the file by itself */
-		read_ctags_file(tags_file, mode, file_tags);
+		read_ctags_file(tags_file, mode, file_tags, arena);
 	}
 	else
 	{
-		while (NULL != (tag = new_tag_from_tags_file(NULL, fp, mode, format)))
+		while (NULL != (tag = new_tag_from_tags_file(NULL, fp, mode, format, arena)))
 			g_ptr_array_add(file_tags, tag);
 		fclose(fp);
 	}
+	tm_tag_arena_free(arena);
 
 	return file_tags;
 }
@@ -590,6 +854,366 @@ gboolean tm_source_file_write_tags_file(const gchar *tags_file, GPtrArray *tags_
 	return ret;
 }
 
+static guint32 add_binary_string(GString *strings, GHashTable *offsets, const gchar *str)
+{
+	gpointer offset;
+
+	if (str == NULL)
+		return GUINT32_TO_LE(BINARY_TAGS_NO_STRING);
+
+	if (! g_hash_table_lookup_extended(offsets, str, NULL, &offset))
+	{
+		offset = GUINT_TO_POINTER(strings->len);
+		g_string_append_len(strings, str, strlen(str) + 1);
+		g_hash_table_insert(offsets, (gpointer) str, offset);
+	}
+	return GUINT32_TO_LE(GPOINTER_TO_UINT(offset));
+}
+
+/*
+ Writes tags to a file in the binary format, which can be mapped directly when
+ it is loaded.
+ @param tags_file The file to write.
+ @param tags_array The tags to write. They have to be sorted and deduplicated
+ by the global tags sort attributes.
+ @return TRUE on success, FALSE on failure.
+*/
+gboolean tm_source_file_write_binary_tags_file(const gchar *tags_file, GPtrArray *tags_array)
+{
+	BinaryTagsHeader header;
+	BinaryTag *records;
+	GHashTable *offsets;
+	GString *strings;
+	FILE *fp;
+	guint i;
+	gboolean ret;
+
+	g_return_val_if_fail(tags_array && tags_file, FALSE);
+
+	/* identical strings (mostly scopes and types) are stored only once */
+	offsets = g_hash_table_new(g_str_hash, g_str_equal);
+	strings = g_string_sized_new(tags_array->len * 32);
+	records = g_new0(BinaryTag, tags_array->len);
+	for (i = 0; i < tags_array->len; i++)
+	{
+		TMTag *tag = TM_TAG(tags_array->pdata[i]);
+		BinaryTag *record = &records[i];
+
+		record->name = add_binary_string(strings, offsets, tag->name);
+		record->arglist = add_binary_string(strings, offsets, tag->arglist);
+		record->scope = add_binary_string(strings, offsets, tag->scope);
+		record->inheritance = add_binary_string(strings, offsets, tag->inheritance);
+		record->var_type = add_binary_string(strings, offsets, tag->var_type);
+		record->type = GUINT32_TO_LE(tag->type);
+		record->line = GUINT32_TO_LE((guint32) tag->line);
+		record->flags = GUINT32_TO_LE(tag->flags);
+		record->local = tag->local ? 1 : 0;
+		record->access = tag->access;
+		record->impl = tag->impl;
+		record->kind_letter = tag->kind_letter;
+	}
+	g_hash_table_destroy(offsets);
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BINARY_TAGS_MAGIC, sizeof(BINARY_TAGS_MAGIC));
+	header.version = GUINT32_TO_LE(BINARY_TAGS_VERSION);
+	header.tag_count = GUINT32_TO_LE(tags_array->len);
+	header.strings_offset = GUINT32_TO_LE(sizeof(header) + tags_array->len * sizeof(BinaryTag));
+	header.strings_size = GUINT32_TO_LE(strings->len);
+
+	ret = FALSE;
+	fp = g_fopen(tags_file, "wb");
+	if (fp)
+	{
+		ret = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+			(tags_array->len == 0 ||
+				fwrite(records, sizeof(BinaryTag), tags_array->len, fp) == tags_array->len) &&
+			(strings->len == 0 || fwrite(strings->str, strings->len, 1, fp) == 1);
+		ret = (fclose(fp) == 0) && ret;
+	}
+
+	g_free(records);
+	g_string_free(strings, TRUE);
+	return ret;
+}
+
+
+static gint cache_file_info_cmp(gconstpointer a, gconstpointer b)
+{
+	const CacheFileInfo *info1 = a;
+	const CacheFileInfo *info2 = b;
+
+	return (info1->mtime > info2->mtime) - (info1->mtime < info2->mtime);
+}
+
+
+/* Removes the least recently written cache files until the cache is smaller than
+ * max_size. Must be called with cache_mutex held.
+ * @return The resulting size of the cache. */
+static guint64 trim_cache(guint64 max_size)
+{
+	GDir *dir = g_dir_open(cache_dir, 0, NULL);
+	GArray *files;
+	const gchar *name;
+	guint64 total = 0;
+	guint i;
+
+	if (!dir)
+		return 0;
+
+	files = g_array_new(FALSE, FALSE, sizeof(CacheFileInfo));
+	while ((name = g_dir_read_name(dir)) != NULL)
+	{
+		CacheFileInfo info;
+		GStatBuf st;
+
+		if (!g_str_has_suffix(name, ".tags"))
+			continue;
+
+		info.path = g_build_filename(cache_dir, name, NULL);
+		if (g_stat(info.path, &st) != 0)
+		{
+			g_free(info.path);
+			continue;
+		}
+		info.mtime = st.st_mtime;
+		info.size = st.st_size;
+		total += info.size;
+		g_array_append_val(files, info);
+	}
+	g_dir_close(dir);
+
+	if (total > max_size)
+	{
+		g_array_sort(files, cache_file_info_cmp);
+		for (i = 0; i < files->len && total > max_size; i++)
+		{
+			CacheFileInfo *info = &g_array_index(files, CacheFileInfo, i);
+
+			if (g_unlink(info->path) == 0)
+				total -= info->size;
+		}
+	}
+
+	for (i = 0; i < files->len; i++)
+		g_free(g_array_index(files, CacheFileInfo, i).path);
+	g_array_free(files, TRUE);
+
+	return total;
+}
+
+
+/* Sets the directory where tags of parsed source files are cached so unchanged
+ files don't have to be parsed again, e.g. after restart.
+ @param dir The cache directory (created if needed), or NULL to disable the cache.
+ @param max_size Maximum size of the cache in bytes; when exceeded, the oldest
+ cache files are removed.
+*/
+void tm_source_file_set_cache_dir(const gchar *dir, guint64 max_size)
+{
+	g_mutex_lock(&cache_mutex);
+
+	g_free(cache_dir);
+	cache_dir = NULL;
+	cache_max_size = max_size;
+	cache_size = 0;
+
+	if (dir && max_size > 0 && g_mkdir_with_parents(dir, 0700) == 0)
+	{
+		cache_dir = g_strdup(dir);
+		cache_size = trim_cache(cache_max_size);
+	}
+
+	g_mutex_unlock(&cache_mutex);
+}
+
+/* Sets how long parsing a single file may take before it is stopped and only
+ the tags found until then are used. Should be set before any parsing.
+ @param limit The time limit in milliseconds, or 0 for no limit.
+*/
+void tm_source_file_set_parse_time_limit(guint limit)
+{
+	parse_time_limit = (gint64) limit * 1000;
+}
+
+
+static gchar *get_cache_path(const TMSourceFile *source_file)
+{
+	gchar *path = NULL;
+
+	g_mutex_lock(&cache_mutex);
+	if (cache_dir)
+	{
+		gchar *hash = g_compute_checksum_for_string(G_CHECKSUM_MD5, source_file->file_name, -1);
+		gchar *name = g_strconcat(hash, ".tags", NULL);
+
+		path = g_build_filename(cache_dir, name, NULL);
+		g_free(name);
+		g_free(hash);
+	}
+	g_mutex_unlock(&cache_mutex);
+
+	return path;
+}
+
+
+/* Entries whose header differs from the current one are rejected, so the header
+ * contains everything the generated tags depend on besides the file contents */
+static gchar *get_cache_header(const TMSourceFile *source_file, gint64 mtime, const gchar *hash)
+{
+	gchar *ignore_hash = tm_ctags_get_ignore_symbols_hash();
+	gchar *header;
+
+	header = g_strdup_printf("# format=tagmanager-cache version=%d geany=%s ignore=%s lang=%s mtime=%"
+		G_GINT64_FORMAT " hash=%s ", TAG_CACHE_VERSION, VERSION, ignore_hash,
+		tm_source_file_get_lang_name(source_file->lang), mtime, hash);
+	g_free(ignore_hash);
+
+	return header;
+}
+
+
+/* the tagmanager format uses bytes >= TA_NAME as separators */
+static gboolean is_cacheable_str(const gchar *str)
+{
+	const guchar *p;
+
+	for (p = (const guchar *) str; p && *p; p++)
+	{
+		if (*p >= TA_NAME || *p == '\n')
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
+static gboolean is_cacheable_tag(const TMTag *tag)
+{
+	return isprint((guchar) tag->name[0]) &&
+		is_cacheable_str(tag->name) && is_cacheable_str(tag->arglist) &&
+		is_cacheable_str(tag->scope) && is_cacheable_str(tag->inheritance) &&
+		is_cacheable_str(tag->var_type);
+}
+
+
+/* Cache file layout: a header line with the cache version, Geany version, hash of
+ * the ignore list, language, modification time and content hash of the source file, the number of tags and the checksum
+ * of the rest of the file, followed by one tag per line in the tagmanager format. */
+static void write_cache(TMSourceFile *source_file, gint64 mtime, const gchar *hash,
+	GPtrArray *tags_array)
+{
+	GString *body = g_string_sized_new(tags_array->len * 64 + 256);
+	gchar *header, *full_header, *checksum, *path;
+	guint i;
+
+	for (i = 0; i < tags_array->len; i++)
+	{
+		TMTag *tag = tags_array->pdata[i];
+
+		if (!is_cacheable_tag(tag))
+		{
+			g_string_free(body, TRUE);
+			return;
+		}
+		append_tag(tag, body, TAG_CACHE_ATTRS);
+	}
+
+	checksum = g_compute_checksum_for_string(G_CHECKSUM_MD5, body->str, body->len);
+	header = get_cache_header(source_file, mtime, hash);
+	full_header = g_strdup_printf("%scount=%u checksum=%s\n", header, tags_array->len, checksum);
+	g_string_prepend(body, full_header);
+
+	path = get_cache_path(source_file);
+	if (path)
+	{
+		GStatBuf st;
+		guint64 old_size = (g_stat(path, &st) == 0) ? (guint64) st.st_size : 0;
+
+		if (g_file_set_contents(path, body->str, body->len, NULL))
+		{
+			g_mutex_lock(&cache_mutex);
+			cache_size += body->len;
+			cache_size -= MIN(old_size, cache_size);
+			if (cache_dir && cache_size > cache_max_size)
+				cache_size = trim_cache(cache_max_size / 4 * 3);
+			g_mutex_unlock(&cache_mutex);
+		}
+	}
+
+	g_free(path);
+	g_free(full_header);
+	g_free(header);
+	g_free(checksum);
+	g_string_free(body, TRUE);
+}
+
+
+/* Appends the cached tags of source_file to tags_array if the cache is valid
+ * for the given modification time and content hash. */
+static gboolean read_cache(TMSourceFile *source_file, gint64 mtime, const gchar *hash,
+	GPtrArray *tags_array)
+{
+	gchar *path = get_cache_path(source_file);
+	gchar *contents = NULL;
+	gchar *header = NULL;
+	gchar *checksum = NULL;
+	gchar stored_checksum[33];
+	gchar *body;
+	guint count;
+	gboolean ret = FALSE;
+
+	if (!path || !g_file_get_contents(path, &contents, NULL, NULL))
+		goto cleanup;
+
+	header = get_cache_header(source_file, mtime, hash);
+	body = strchr(contents, '\n');
+	if (!body || !g_str_has_prefix(contents, header) ||
+		sscanf(contents + strlen(header), "count=%u checksum=%32s", &count, stored_checksum) != 2)
+		goto cleanup;
+	body++;
+
+	checksum = g_compute_checksum_for_string(G_CHECKSUM_MD5, body, -1);
+	if (strcmp(checksum, stored_checksum) == 0)
+	{
+		guint start = tags_array->len;
+		gchar *line = body;
+		TMTagArena *arena = tm_tag_arena_new();
+
+		while (*line)
+		{
+			gchar *next = strchr(line, '\n');
+			TMTag *tag = tm_tag_arena_new_tag(arena);
+
+			if (!init_tag_from_line(tag, source_file, (guchar *) line, source_file->lang))
+			{
+				tm_tag_unref(tag);
+				break;
+			}
+			tag->lang = source_file->lang;
+			g_ptr_array_add(tags_array, tag);
+			line = next ? next + 1 : line + strlen(line);
+		}
+		tm_tag_arena_free(arena);
+
+		ret = tags_array->len - start == count;
+		if (!ret)
+		{
+			guint i;
+
+			for (i = start; i < tags_array->len; i++)
+				tm_tag_unref(tags_array->pdata[i]);
+			g_ptr_array_set_size(tags_array, start);
+		}
+	}
+
+cleanup:
+	g_free(checksum);
+	g_free(header);
+	g_free(contents);
+	g_free(path);
+	return ret;
+}
+
 
 /* Initializes a TMSourceFile structure from a file name. */
 static gboolean tm_source_file_init(TMSourceFile *source_file, const char *file_name,
@@ -670,11 +1294,16 @@ TMSourceFile *tm_source_file_new(const char *file_name, const char *name)
 		return NULL;
 	}
 	priv->refcount = 1;
+	memset(&priv->includes, 0, sizeof(priv->includes));
+	priv->parse_time = -1;
+	priv->overruns = 0;
+	priv->refs = NULL;
 	return &priv->public;
 }
 
 
-static TMSourceFile *tm_source_file_dup(TMSourceFile *source_file)
+/* Increments the reference count of source_file */
+TMSourceFile *tm_source_file_dup(TMSourceFile *source_file)
 {
 	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
 
@@ -684,6 +1313,26 @@ static TMSourceFile *tm_source_file_dup(TMSourceFile *source_file)
 	return source_file;
 }
 
+/* Gets how long the last parse of source_file took in microseconds, or -1 if
+ * its tags came from the cache or it wasn't parsed */
+gint tm_source_file_get_parse_time(TMSourceFile *source_file)
+{
+	return g_atomic_int_get(&((TMSourceFilePriv *) source_file)->parse_time);
+}
+
+/* Gets how many times in a row parsing source_file was stopped because it took
+ * longer than the limit set by tm_source_file_set_parse_time_limit() */
+guint tm_source_file_get_overruns(TMSourceFile *source_file)
+{
+	return (guint) g_atomic_int_get(&((TMSourceFilePriv *) source_file)->overruns);
+}
+
+/* Gets the files included by source_file as cached by the workspace */
+TMSourceFileIncludes *tm_source_file_get_includes(TMSourceFile *source_file)
+{
+	return &((TMSourceFilePriv *) source_file)->includes;
+}
+
 /* Destroys the contents of the source file. Note that the tags are owned by the
  source file and are also destroyed when the source file is destroyed. If pointers
  to these tags are used elsewhere, then those tag arrays should be rebuilt.
@@ -697,6 +1346,131 @@ static void tm_source_file_destroy(TMSourceFile *source_file)
 	g_free(source_file->file_name);
 	tm_tags_array_free(source_file->tags_array, TRUE);
 	source_file->tags_array = NULL;
+	tm_source_file_clear_includes(source_file);
+	tm_source_file_set_refs(source_file, NULL);
+}
+
+/* Frees the cached included files of source_file */
+void tm_source_file_clear_includes(TMSourceFile *source_file)
+{
+	TMSourceFileIncludes *includes = tm_source_file_get_includes(source_file);
+
+	if (includes->files)
+		g_ptr_array_free(includes->files, TRUE);
+	if (includes->depths)
+		g_hash_table_destroy(includes->depths);
+	includes->files = NULL;
+	includes->depths = NULL;
+	includes->header_candidates = NULL;
+	includes->stamp = 0;
+}
+
+/* Hashes the len bytes long word name for the reference index */
+guint32 tm_source_file_hash_ref(const gchar *name, gsize len)
+{
+	guint32 hash = 2166136261u;
+	gsize i;
+
+	for (i = 0; i < len; i++)
+		hash = (hash ^ (guchar) name[i]) * 16777619u;
+	return hash;
+}
+
+static gboolean is_ref_char(guchar c)
+{
+	return g_ascii_isalnum(c) || c == '_';
+}
+
+static gint compare_refs(gconstpointer a, gconstpointer b)
+{
+	guint32 h1 = *((const guint32 *) a);
+	guint32 h2 = *((const guint32 *) b);
+
+	return h1 < h2 ? -1 : h1 > h2;
+}
+
+/* Collects the sorted and deduplicated hashes of the words (runs of ASCII
+ * alphanumeric characters and underscores) of buf. This covers the references
+ * like calls, includes and type uses, which ctags only reports for a few kinds. */
+static GArray *scan_refs(const guchar *buf, gsize size)
+{
+	GArray *hashes = g_array_new(FALSE, FALSE, sizeof(guint32));
+	GArray *refs;
+	gsize i = 0;
+	guint j, len = 0;
+
+	while (i < size)
+	{
+		gsize start;
+		guint32 hash;
+
+		if (!is_ref_char(buf[i]))
+		{
+			i++;
+			continue;
+		}
+		for (start = i; i < size && is_ref_char(buf[i]); i++);
+		hash = tm_source_file_hash_ref((const gchar *) buf + start, i - start);
+		g_array_append_val(hashes, hash);
+	}
+
+	g_array_sort(hashes, compare_refs);
+	for (j = 0; j < hashes->len; j++)
+	{
+		if (len == 0 || g_array_index(hashes, guint32, j) != g_array_index(hashes, guint32, len - 1))
+			g_array_index(hashes, guint32, len++) = g_array_index(hashes, guint32, j);
+	}
+
+	/* the index lives as long as the file, don't waste the growth space */
+	refs = g_array_sized_new(FALSE, FALSE, sizeof(guint32), len);
+	g_array_append_vals(refs, hashes->data, len);
+	g_array_free(hashes, TRUE);
+	return refs;
+}
+
+/* Sets the reference index of source_file, replacing the previous one.
+ @param source_file The source file.
+ @param refs The index created by tm_source_file_parse_tags(), owned by
+ source_file afterwards, or NULL to drop the index. */
+void tm_source_file_set_refs(TMSourceFile *source_file, GArray *refs)
+{
+	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
+
+	if (priv->refs)
+		g_array_free(priv->refs, TRUE);
+	priv->refs = refs;
+}
+
+/* Checks whether the word name may occur in source_file according to its
+ reference index. As only hashes are stored, the answer can be a false positive.
+ Files without an index may reference anything.
+ @param source_file The source file.
+ @param name A word consisting of ASCII alphanumeric characters and underscores.
+ @return FALSE if name doesn't occur in source_file. */
+gboolean tm_source_file_may_reference(TMSourceFile *source_file, const gchar *name)
+{
+	GArray *refs = ((TMSourceFilePriv *) source_file)->refs;
+	guint32 hash;
+	guint lo = 0, hi;
+
+	if (!refs)
+		return TRUE;
+
+	hash = tm_source_file_hash_ref(name, strlen(name));
+	hi = refs->len;
+	while (lo < hi)
+	{
+		guint mid = lo + (hi - lo) / 2;
+		guint32 val = g_array_index(refs, guint32, mid);
+
+		if (val == hash)
+			return TRUE;
+		if (val < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return FALSE;
 }
 
 /** Decrements the reference count of @a source_file
@@ -727,19 +1501,117 @@ GType tm_source_file_get_type(void);
 
 G_DEFINE_BOXED_TYPE(TMSourceFile, tm_source_file, tm_source_file_dup, tm_source_file_free);
 
+/* Parses the text-buffer or source file and appends the tags to tags_array.
+ Can be called from any thread.
+ @param source_file The source file to parse
+ @param text_buf The text buffer to parse
+ @param buf_size The size of text_buf.
+ @param use_buffer Set FALSE to ignore the buffer and parse the file directly or
+ TRUE to parse the buffer and ignore the file content.
+ @param use_cache Whether to load the tags from the tag cache when the parsed
+ contents didn't change since they were cached, and to store them in the cache
+ otherwise. Pass FALSE for contents which don't correspond to the file on disk.
+ @param tags_array The array the tags are appended to.
+ @param refs Location to store the reference index of the parsed contents, see
+ tm_source_file_set_refs(), or NULL. Set to NULL when the file can't be read.
+ @param cancelled Stops the parse when set to TRUE from another thread, or NULL.
+ @return FALSE when the parse was stopped early, see
+ tm_source_file_set_parse_time_limit(), and tags_array is incomplete.
+*/
+gboolean tm_source_file_parse_tags(TMSourceFile *source_file, guchar *text_buf, gsize buf_size,
+	gboolean use_buffer, gboolean use_cache, GPtrArray *tags_array, GArray **refs,
+	gint *cancelled)
+{
+	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
+	gchar *contents = NULL;
+	gchar *hash = NULL;
+	gint64 mtime = 0;
+	gboolean cached = FALSE;
+	gboolean truncated = FALSE;
+
+	g_atomic_int_set(&priv->parse_time, -1);
+
+	/* the cache lookup needs the content hash and the reference index the
+	 * contents, so read the file ourselves and let ctags parse the buffer */
+	if (!use_buffer && ((use_cache && cache_dir) || refs))
+	{
+		gsize length;
+
+		if (g_file_get_contents(source_file->file_name, &contents, &length, NULL))
+		{
+			text_buf = (guchar *) contents;
+			buf_size = length;
+			use_buffer = TRUE;
+		}
+	}
+
+	if (refs)
+		*refs = use_buffer ? scan_refs(text_buf, buf_size) : NULL;
+
+	/* cache_dir is only set during startup, before any parsing */
+	if (use_cache && cache_dir)
+	{
+		GStatBuf st;
+
+		if (g_stat(source_file->file_name, &st) == 0)
+		{
+			if (use_buffer)
+			{
+				mtime = st.st_mtime;
+				hash = g_compute_checksum_for_data(G_CHECKSUM_SHA1, text_buf, buf_size);
+				cached = read_cache(source_file, mtime, hash, tags_array);
+			}
+		}
+	}
+
+	if (!cached && (!use_buffer || buf_size > 0))
+	{
+		gint64 start = g_get_monotonic_time();
+
+		truncated = tm_ctags_parse(use_buffer ? text_buf : NULL, buf_size,
+			source_file->file_name, source_file->lang, source_file, tags_array,
+			parse_time_limit, cancelled);
+		g_atomic_int_set(&priv->parse_time,
+			(gint) MIN(g_get_monotonic_time() - start, G_MAXINT));
+
+		/* cancelled parses say nothing about the file */
+		if (!cancelled || !g_atomic_int_get(cancelled))
+		{
+			/* warn only once until the file can be parsed in time again */
+			if (truncated && g_atomic_int_add(&priv->overruns, 1) == 0)
+			{
+				/* this runs in the parser threads */
+				tm_ctags_log_warning("Parsing %s took more than %" G_GINT64_FORMAT
+					" ms, its symbols are incomplete", source_file->file_name, parse_time_limit / 1000);
+			}
+			else if (!truncated)
+				g_atomic_int_set(&priv->overruns, 0);
+		}
+		if (hash && !truncated)
+			write_cache(source_file, mtime, hash, tags_array);
+	}
+
+	g_free(hash);
+	g_free(contents);
+	return !truncated;
+}
+
 /* Parses the text-buffer or source file and regenarates the tags.
  @param source_file The source file to parse
  @param text_buf The text buffer to parse
  @param buf_size The size of text_buf.
  @param use_buffer Set FALSE to ignore the buffer and parse the file directly or
  TRUE to parse the buffer and ignore the file content.
+ @param use_cache Whether the tag cache can be used, see tm_source_file_parse_tags().
+ @param index_refs Whether to create the reference index of the parsed contents,
+ see tm_source_file_set_refs(). Otherwise the file has no index afterwards.
  @return TRUE on success, FALSE on failure
 */
 gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize buf_size,
-	gboolean use_buffer)
+	gboolean use_buffer, gboolean use_cache, gboolean index_refs)
 {
-	const char *file_name;
 	gboolean retry = TRUE;
+	GArray *refs = NULL;
 
 	if ((NULL == source_file) || (NULL == source_file->file_name))
 	{
@@ -750,22 +1622,24 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 	if (source_file->lang == TM_PARSER_NONE)
 	{
 		tm_tags_array_free(source_file->tags_array, FALSE);
+		tm_source_file_set_refs(source_file, NULL);
 		return FALSE;
 	}
 
-	file_name = source_file->file_name;
-
 	if (use_buffer && (NULL == text_buf || 0 == buf_size))
 	{
 		/* Empty buffer, "parse" by setting empty tag array */
 		tm_tags_array_free(source_file->tags_array, FALSE);
+		tm_source_file_set_refs(source_file,
+			index_refs ? g_array_new(FALSE, FALSE, sizeof(guint32)) : NULL);
 		return TRUE;
 	}
 
 	tm_tags_array_free(source_file->tags_array, FALSE);
 
-	tm_ctags_parse(use_buffer ? text_buf : NULL, buf_size, file_name,
-		source_file->lang, source_file);
+	tm_source_file_parse_tags(source_file, text_buf, buf_size, use_buffer, use_cache,
+		source_file->tags_array, index_refs ? &refs : NULL, NULL);
+	tm_source_file_set_refs(source_file, refs);
 
 	return !retry;
 }
@@ -52,17 +52,56 @@ G_DEPRECATED_FOR(utils_get_real_path)
 
 #ifdef GEANY_PRIVATE
 
+/* Files included by a source file, cached by the workspace */
+typedef struct
+{
+	GPtrArray *files; /* included TMSourceFiles, nearest first */
+	GHashTable *depths; /* TMSourceFile -> include depth, 1 for direct includes */
+	GPtrArray *header_candidates; /* TMSourceFiles that could be the header of the file */
+	guint stamp; /* workspace includes stamp when computed, 0 if not computed */
+	guint signature; /* hash of the include tag names of the file */
+} TMSourceFileIncludes;
+
+TMSourceFile *tm_source_file_dup(TMSourceFile *source_file);
+
 const gchar *tm_source_file_get_lang_name(TMParserType lang);
 
 TMParserType tm_source_file_get_named_lang(const gchar *name);
 
 gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize buf_size,
-	gboolean use_buffer);
+	gboolean use_buffer, gboolean use_cache, gboolean index_refs);
+
+gboolean tm_source_file_parse_tags(TMSourceFile *source_file, guchar *text_buf, gsize buf_size,
+	gboolean use_buffer, gboolean use_cache, GPtrArray *tags_array, GArray **refs,
+	gint *cancelled);
 
-GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mode);
+void tm_source_file_set_cache_dir(const gchar *dir, guint64 max_size);
+
+void tm_source_file_set_parse_time_limit(guint limit);
+
+GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mode,
+	gboolean *sorted, GError **error);
 
 gboolean tm_source_file_write_tags_file(const gchar *tags_file, GPtrArray *tags_array);
 
+gboolean tm_source_file_write_binary_tags_file(const gchar *tags_file, GPtrArray *tags_array);
+
+void tm_source_file_free_binary_tags(void);
+
+gint tm_source_file_get_parse_time(TMSourceFile *source_file);
+
+guint tm_source_file_get_overruns(TMSourceFile *source_file);
+
+TMSourceFileIncludes *tm_source_file_get_includes(TMSourceFile *source_file);
+
+void tm_source_file_clear_includes(TMSourceFile *source_file);
+
+guint32 tm_source_file_hash_ref(const gchar *name, gsize len);
+
+void tm_source_file_set_refs(TMSourceFile *source_file, GArray *refs);
+
+gboolean tm_source_file_may_reference(TMSourceFile *source_file, const gchar *name);
+
 gchar tm_source_file_get_tag_impl(const gchar *impl);
 
 gchar tm_source_file_get_tag_access(const gchar *access);
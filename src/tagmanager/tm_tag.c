@@ -83,6 +83,43 @@ typedef struct
 	gboolean first;
 } TMSortOptions;
 
+/* Tags created together (e.g. by one parse) are allocated from blocks of a
+ * TMTagArena instead of one by one. A block goes away in one step once all its
+ * tags have been destroyed and the arena doesn't allocate from it anymore. */
+typedef struct
+{
+	gint refcount; /* live tags, plus one while the arena allocates from the block */
+	TMTag tags[];
+} TMTagBlock;
+
+struct TMTagArena
+{
+	TMTagBlock *block;
+	guint used;
+	guint size;
+};
+
+/* block sizes grow up to the maximum so small files don't waste much space;
+ * the maximum has to fit TMTag::arena_index */
+#define TAG_ARENA_MIN_BLOCK 16
+#define TAG_ARENA_MAX_BLOCK 1024
+
+/* The strings of all tags are interned in this pool (string -> refcount), so
+ * scopes, types etc. repeating across the workspace are stored only once.
+ * Tags are created and destroyed from the parser threads too, so the pool is
+ * split into shards with their own lock to keep the threads from contending. */
+#define STRING_POOL_SHARD_BITS 4
+
+typedef struct
+{
+	GMutex mutex;
+	GHashTable *strings;
+	gsize size;      /* bytes of the unique strings */
+	gsize requested; /* bytes all references would take when duplicated */
+} StringPoolShard;
+
+static StringPoolShard string_pool[1 << STRING_POOL_SHARD_BITS];
+
 /** Gets the GType for a TMTag.
  *
  * @return TMTag type
@@ -99,6 +136,113 @@ GType tm_tag_get_type(void)
 	return gtype;
 }
 
+/* The shard is picked by the high bits of the mixed string hash because the hash
+ * tables of the shards use the low bits */
+static StringPoolShard *get_string_pool_shard(const gchar *str)
+{
+	guint32 hash = g_str_hash(str) * 0x9E3779B1u;
+
+	return &string_pool[hash >> (32 - STRING_POOL_SHARD_BITS)];
+}
+
+/*
+ Returns the interned copy of str, adding a reference to it. All strings assigned
+ to tags have to be obtained this way because tm_tag_unref() releases them with
+ tm_tag_release_str().
+ @param str The string to intern, can be NULL.
+ @return The interned string, NULL if str is NULL.
+*/
+gchar *tm_tag_intern_str(const gchar *str)
+{
+	StringPoolShard *shard;
+	gpointer key, value;
+	gsize len;
+
+	if (!str)
+		return NULL;
+
+	len = strlen(str) + 1;
+	shard = get_string_pool_shard(str);
+	g_mutex_lock(&shard->mutex);
+	if (G_UNLIKELY(!shard->strings))
+		shard->strings = g_hash_table_new(g_str_hash, g_str_equal);
+	if (g_hash_table_lookup_extended(shard->strings, str, &key, &value))
+		g_hash_table_insert(shard->strings, key, GUINT_TO_POINTER(GPOINTER_TO_UINT(value) + 1));
+	else
+	{
+		key = g_strdup(str);
+		g_hash_table_insert(shard->strings, key, GUINT_TO_POINTER(1));
+		shard->size += len;
+	}
+	shard->requested += len;
+	g_mutex_unlock(&shard->mutex);
+
+	return key;
+}
+
+/*
+ Drops a reference from a string obtained by tm_tag_intern_str().
+ @param str The interned string, can be NULL.
+*/
+void tm_tag_release_str(gchar *str)
+{
+	StringPoolShard *shard;
+	gpointer value;
+	guint refcount;
+	gsize len;
+
+	if (!str)
+		return;
+
+	len = strlen(str) + 1;
+	shard = get_string_pool_shard(str);
+	g_mutex_lock(&shard->mutex);
+	value = shard->strings ? g_hash_table_lookup(shard->strings, str) : NULL;
+	refcount = GPOINTER_TO_UINT(value);
+	if (G_UNLIKELY(refcount == 0))
+		g_critical("Releasing string \"%s\" which is not interned", str);
+	else if (refcount == 1)
+	{
+		g_hash_table_remove(shard->strings, str);
+		shard->size -= len;
+		shard->requested -= len;
+		g_free(str);
+	}
+	else
+	{
+		g_hash_table_insert(shard->strings, str, GUINT_TO_POINTER(refcount - 1));
+		shard->requested -= len;
+	}
+	g_mutex_unlock(&shard->mutex);
+}
+
+/*
+ Gets the statistics of the interned tag strings.
+ @param count Return location for the number of unique strings.
+ @param size Return location for the bytes used by the unique strings.
+ @param saved Return location for the bytes saved compared to duplicating the
+ strings for every tag.
+*/
+void tm_tag_get_string_pool_stats(guint *count, gsize *size, gsize *saved)
+{
+	gsize requested = 0;
+	guint i;
+
+	*count = 0;
+	*size = 0;
+	for (i = 0; i < G_N_ELEMENTS(string_pool); i++)
+	{
+		StringPoolShard *shard = &string_pool[i];
+
+		g_mutex_lock(&shard->mutex);
+		*count += shard->strings ? g_hash_table_size(shard->strings) : 0;
+		*size += shard->size;
+		requested += shard->requested;
+		g_mutex_unlock(&shard->mutex);
+	}
+	*saved = requested - *size;
+}
+
 /*
  Creates a new tag structure and returns a pointer to it.
  @return the new TMTag structure. This should be free()-ed using tm_tag_free()
@@ -113,6 +257,103 @@ TMTag *tm_tag_new(void)
 	return tag;
 }
 
+/*
+ Gets the mask of the (case-insensitive) characters occurring in str: one bit
+ per letter plus bits for digits, underscores and other characters. A name can
+ only contain a pattern as a subsequence if the name's mask contains the
+ pattern's mask.
+ @param str The string.
+ @return The mask, never 0.
+*/
+guint32 tm_tag_get_str_mask(const gchar *str)
+{
+	guint32 mask = 1u << 31;
+
+	for (; *str; str++)
+	{
+		gchar c = g_ascii_tolower(*str);
+
+		if (c >= 'a' && c <= 'z')
+			mask |= 1u << (c - 'a');
+		else if (g_ascii_isdigit(c))
+			mask |= 1u << 26;
+		else if (c == '_')
+			mask |= 1u << 27;
+		else
+			mask |= 1u << 28;
+	}
+	return mask;
+}
+
+/*
+ Gets the character mask of the tag name, see tm_tag_get_str_mask(). The mask
+ is computed on first use and stored in the tag. Only call from the main thread.
+ @param tag The tag.
+ @return The mask.
+*/
+guint32 tm_tag_get_name_mask(TMTag *tag)
+{
+	if (G_UNLIKELY(tag->name_mask == 0))
+		tag->name_mask = tm_tag_get_str_mask(tag->name);
+	return tag->name_mask;
+}
+
+/*
+ Creates a new tag arena used to allocate tags which are likely to be freed
+ together, such as the tags of a single parse.
+ @return The new arena. Free it with tm_tag_arena_free() when done allocating.
+*/
+TMTagArena *tm_tag_arena_new(void)
+{
+	return g_new0(TMTagArena, 1);
+}
+
+static void tag_block_unref(TMTagBlock *block)
+{
+	if (g_atomic_int_dec_and_test(&block->refcount))
+		g_free(block);
+}
+
+/*
+ Creates a new tag allocated from the given arena. The tag is reference counted
+ like tags created by tm_tag_new().
+ @param arena The arena.
+ @return The new TMTag structure.
+*/
+TMTag *tm_tag_arena_new_tag(TMTagArena *arena)
+{
+	TMTag *tag;
+
+	if (!arena->block || arena->used == arena->size)
+	{
+		if (arena->block)
+			tag_block_unref(arena->block);
+		arena->size = arena->size ? MIN(arena->size * 2, TAG_ARENA_MAX_BLOCK) : TAG_ARENA_MIN_BLOCK;
+		arena->block = g_malloc(sizeof(TMTagBlock) + arena->size * sizeof(TMTag));
+		arena->block->refcount = 1;
+		arena->used = 0;
+	}
+
+	tag = &arena->block->tags[arena->used];
+	memset(tag, 0, sizeof(TMTag));
+	tag->refcount = 1;
+	tag->arena_index = (guint16) ++arena->used;
+	g_atomic_int_inc(&arena->block->refcount);
+
+	return tag;
+}
+
+/*
+ Frees the arena. Tags allocated from it stay valid until they are unreferenced.
+ @param arena The arena.
+*/
+void tm_tag_arena_free(TMTagArena *arena)
+{
+	if (arena->block)
+		tag_block_unref(arena->block);
+	g_free(arena);
+}
+
 /*
  Destroys a TMTag structure, i.e. frees all elements except the tag itself.
  @param tag The TMTag structure to destroy
@@ -120,27 +361,35 @@ TMTag *tm_tag_new(void)
 */
 static void tm_tag_destroy(TMTag *tag)
 {
-	g_free(tag->name);
-	g_free(tag->arglist);
-	g_free(tag->scope);
-	g_free(tag->inheritance);
-	g_free(tag->var_type);
+	tm_tag_release_str(tag->name);
+	tm_tag_release_str(tag->arglist);
+	tm_tag_release_str(tag->scope);
+	tm_tag_release_str(tag->inheritance);
+	tm_tag_release_str(tag->var_type);
 }
 
 
 /*
  Drops a reference from a TMTag. If the reference count reaches 0, this function
  destroys all data in the tag and frees the tag structure as well.
+ Tags read from a binary tags file are never freed here, they are owned by the
+ file mapping and freed by tm_source_file_free_binary_tags().
  @param tag Pointer to a TMTag structure
 */
 void tm_tag_unref(TMTag *tag)
 {
 	/* be NULL-proof because tm_tag_free() was NULL-proof and we indent to be a
 	 * drop-in replacement of it */
-	if (NULL != tag && g_atomic_int_dec_and_test(&tag->refcount))
+	if (NULL != tag && !tag->mapped && g_atomic_int_dec_and_test(&tag->refcount))
 	{
 		tm_tag_destroy(tag);
-		TAG_FREE(tag);
+		if (tag->arena_index)
+		{
+			TMTag *first = tag - (tag->arena_index - 1);
+			tag_block_unref((TMTagBlock *) ((gchar *) first - G_STRUCT_OFFSET(TMTagBlock, tags)));
+		}
+		else
+			TAG_FREE(tag);
 	}
 }
 
@@ -155,6 +404,22 @@ TMTag *tm_tag_ref(TMTag *tag)
 	return tag;
 }
 
+/* Tag strings are interned so equal pointers mean equal strings; this also
+ * holds for two NULLs, which compare like two empty strings */
+static gint tag_strcmp(const gchar *s1, const gchar *s2)
+{
+	if (s1 == s2)
+		return 0;
+	return strcmp(FALLBACK(s1, ""), FALLBACK(s2, ""));
+}
+
+static gint tag_strncmp(const gchar *s1, const gchar *s2, gsize n)
+{
+	if (s1 == s2)
+		return 0;
+	return strncmp(FALLBACK(s1, ""), FALLBACK(s2, ""), n);
+}
+
 /*
  Inbuilt tag comparison function.
 */
@@ -174,9 +439,9 @@ static gint tm_tag_compare(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 	if (NULL == sort_options->sort_attrs)
 	{
 		if (sort_options->partial)
-			return strncmp(FALLBACK(t1->name, ""), FALLBACK(t2->name, ""), strlen(FALLBACK(t1->name, "")));
+			return tag_strncmp(t1->name, t2->name, strlen(FALLBACK(t1->name, "")));
 		else
-			return strcmp(FALLBACK(t1->name, ""), FALLBACK(t2->name, ""));
+			return tag_strcmp(t1->name, t2->name);
 	}
 
 	for (sort_attr = sort_options->sort_attrs; returnval == 0 && *sort_attr != tm_tag_attr_none_t; ++ sort_attr)
@@ -185,9 +450,9 @@ static gint tm_tag_compare(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 		{
 			case tm_tag_attr_name_t:
 				if (sort_options->partial)
-					returnval = strncmp(FALLBACK(t1->name, ""), FALLBACK(t2->name, ""), strlen(FALLBACK(t1->name, "")));
+					returnval = tag_strncmp(t1->name, t2->name, strlen(FALLBACK(t1->name, "")));
 				else
-					returnval = strcmp(FALLBACK(t1->name, ""), FALLBACK(t2->name, ""));
+					returnval = tag_strcmp(t1->name, t2->name);
 				break;
 			case tm_tag_attr_file_t:
 				returnval = t1->file - t2->file;
@@ -199,10 +464,10 @@ static gint tm_tag_compare(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 				returnval = t1->type - t2->type;
 				break;
 			case tm_tag_attr_scope_t:
-				returnval = strcmp(FALLBACK(t1->scope, ""), FALLBACK(t2->scope, ""));
+				returnval = tag_strcmp(t1->scope, t2->scope);
 				break;
 			case tm_tag_attr_arglist_t:
-				returnval = strcmp(FALLBACK(t1->arglist, ""), FALLBACK(t2->arglist, ""));
+				returnval = tag_strcmp(t1->arglist, t2->arglist);
 				if (returnval != 0)
 				{
 					int line_diff = (t1->line - t2->line);
@@ -211,7 +476,7 @@ static gint tm_tag_compare(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 				}
 				break;
 			case tm_tag_attr_vartype_t:
-				returnval = strcmp(FALLBACK(t1->var_type, ""), FALLBACK(t2->var_type, ""));
+				returnval = tag_strcmp(t1->var_type, t2->var_type);
 				break;
 		}
 	}
@@ -225,17 +490,17 @@ gboolean tm_tags_equal(const TMTag *a, const TMTag *b)
 
 	return (a->line == b->line &&
 			a->file == b->file /* ptr comparison */ &&
-			strcmp(FALLBACK(a->name, ""), FALLBACK(b->name, "")) == 0 &&
+			tag_strcmp(a->name, b->name) == 0 &&
 			a->type == b->type &&
 			a->local == b->local &&
 			a->flags == b->flags &&
 			a->access == b->access &&
 			a->impl == b->impl &&
 			a->lang == b->lang &&
-			strcmp(FALLBACK(a->scope, ""), FALLBACK(b->scope, "")) == 0 &&
-			strcmp(FALLBACK(a->arglist, ""), FALLBACK(b->arglist, "")) == 0 &&
-			strcmp(FALLBACK(a->inheritance, ""), FALLBACK(b->inheritance, "")) == 0 &&
-			strcmp(FALLBACK(a->var_type, ""), FALLBACK(b->var_type, "")) == 0);
+			tag_strcmp(a->scope, b->scope) == 0 &&
+			tag_strcmp(a->arglist, b->arglist) == 0 &&
+			tag_strcmp(a->inheritance, b->inheritance) == 0 &&
+			tag_strcmp(a->var_type, b->var_type) == 0);
 }
 
 /*
@@ -491,6 +756,206 @@ GPtrArray *tm_tags_merge(GPtrArray *big_array, GPtrArray *small_array,
 	return res_array;
 }
 
+typedef struct
+{
+	GPtrArray *tags;
+	guint pos;
+	guint index;  /* index of tags in the merged arrays */
+} MergeSource;
+
+/* heads are ordered by their tag and then by the array they come from so that
+ * the merge is stable */
+static gint merge_source_compare(MergeSource *s1, MergeSource *s2, TMSortOptions *sort_options)
+{
+	gint cmp = tm_tag_compare(&s1->tags->pdata[s1->pos], &s2->tags->pdata[s2->pos], sort_options);
+
+	if (cmp != 0)
+		return cmp;
+	return (s1->index < s2->index) ? -1 : 1;
+}
+
+static void merge_heap_sift_down(MergeSource *heap, guint heap_len, guint i,
+	TMSortOptions *sort_options)
+{
+	while (TRUE)
+	{
+		guint smallest = i;
+		guint left = 2 * i + 1;
+		guint right = left + 1;
+		MergeSource tmp;
+
+		if (left < heap_len && merge_source_compare(&heap[left], &heap[smallest], sort_options) < 0)
+			smallest = left;
+		if (right < heap_len && merge_source_compare(&heap[right], &heap[smallest], sort_options) < 0)
+			smallest = right;
+		if (smallest == i)
+			break;
+
+		tmp = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = tmp;
+		i = smallest;
+	}
+}
+
+/*
+ Merges several sorted arrays into a new sorted array using a k-way merge.
+ The result is the same as concatenating the arrays and sorting them with
+ tm_tags_sort(), including which of several equal tags survives deduplication
+ (the one from the last array), but the merge only needs O(n log k) comparisons.
+ @param arrays The arrays to merge, each sorted by sort_attributes.
+ @param count The number of arrays.
+ @param sort_attributes The sort attributes of the arrays.
+ @param dedup Whether to deduplicate the merged array.
+ @param unref_duplicates Whether to unref the removed duplicates.
+ @return The merged array.
+*/
+GPtrArray *tm_tags_merge_sorted(GPtrArray **arrays, guint count,
+	TMTagAttrType *sort_attributes, gboolean dedup, gboolean unref_duplicates)
+{
+	TMSortOptions sort_options;
+	MergeSource *heap = g_new(MergeSource, count);
+	GPtrArray *res_array;
+	guint total = 0;
+	guint heap_len = 0;
+	guint i;
+
+	sort_options.sort_attrs = sort_attributes;
+	sort_options.partial = FALSE;
+
+	for (i = 0; i < count; i++)
+	{
+		total += arrays[i]->len;
+		if (arrays[i]->len > 0)
+		{
+			heap[heap_len].tags = arrays[i];
+			heap[heap_len].pos = 0;
+			heap[heap_len].index = i;
+			heap_len++;
+		}
+	}
+	res_array = g_ptr_array_sized_new(total);
+
+	for (i = heap_len / 2; i-- > 0;)
+		merge_heap_sift_down(heap, heap_len, i, &sort_options);
+
+	while (heap_len > 0)
+	{
+		MergeSource *top = &heap[0];
+		gpointer tag = top->tags->pdata[top->pos];
+
+		if (dedup && res_array->len > 0 &&
+			tm_tag_compare(&res_array->pdata[res_array->len - 1], &tag, &sort_options) == 0)
+		{
+			/* keep the last of the equal tags like tm_tags_dedup() */
+			if (unref_duplicates)
+				tm_tag_unref(res_array->pdata[res_array->len - 1]);
+			res_array->pdata[res_array->len - 1] = tag;
+		}
+		else
+			g_ptr_array_add(res_array, tag);
+
+		top->pos++;
+		if (top->pos == top->tags->len)
+			heap[0] = heap[--heap_len];
+		merge_heap_sift_down(heap, heap_len, 0, &sort_options);
+	}
+
+	g_free(heap);
+	return res_array;
+}
+
+/* Returns the index of the first tag in tags_array[start, end) which is not
+ * smaller than tag */
+static guint lower_bound(GPtrArray *tags_array, guint start, guint end, TMTag *tag,
+	TMSortOptions *sort_options)
+{
+	while (start < end)
+	{
+		guint mid = start + (end - start) / 2;
+
+		if (tm_tag_compare(&tags_array->pdata[mid], &tag, sort_options) < 0)
+			start = mid + 1;
+		else
+			end = mid;
+	}
+	return start;
+}
+
+/*
+ Inserts the tags of small_array into big_array in place. Both arrays have to be
+ sorted by sort_attributes. Unlike tm_tags_merge(), the position of each inserted
+ tag is found by binary search and the tags of big_array in-between are moved in
+ blocks, so the number of comparisons only depends on the number of inserted tags
+ and no new array is allocated. Like tm_tags_merge(), a tag of big_array equal to
+ an inserted tag is replaced by it.
+ @param big_array The array to insert the tags into.
+ @param small_array The tags to insert.
+ @param sort_attributes The sort attributes of both arrays.
+ @param unref_duplicates Whether to unref the replaced tags.
+*/
+void tm_tags_insert(GPtrArray *big_array, GPtrArray *small_array,
+	TMTagAttrType *sort_attributes, gboolean unref_duplicates)
+{
+	TMSortOptions sort_options;
+	guint *positions;
+	guint old_len = big_array->len;
+	guint inserted = 0;
+	guint start = 0;
+	guint src_end, i;
+
+	if (small_array->len == 0)
+		return;
+
+	sort_options.sort_attrs = sort_attributes;
+	sort_options.partial = FALSE;
+
+	/* G_MAXUINT for tags replacing an existing tag */
+	positions = g_new(guint, small_array->len);
+	for (i = 0; i < small_array->len; i++)
+	{
+		TMTag *tag = small_array->pdata[i];
+		guint pos = lower_bound(big_array, start, old_len, tag, &sort_options);
+
+		if (pos < old_len &&
+			tm_tag_compare(&big_array->pdata[pos], &tag, &sort_options) == 0)
+		{
+			if (unref_duplicates)
+				tm_tag_unref(big_array->pdata[pos]);
+			big_array->pdata[pos] = tag;
+			positions[i] = G_MAXUINT;
+			/* the next equal tag gets inserted after this one */
+			start = pos + 1;
+		}
+		else
+		{
+			positions[i] = pos;
+			start = pos;
+			inserted++;
+		}
+	}
+
+	/* move the blocks between the insert positions from the end so that each
+	 * tag of big_array is moved at most once */
+	g_ptr_array_set_size(big_array, old_len + inserted);
+	src_end = old_len;
+	for (i = small_array->len; i-- > 0 && inserted > 0;)
+	{
+		guint pos = positions[i];
+
+		if (pos == G_MAXUINT)
+			continue;
+
+		memmove(&big_array->pdata[pos + inserted], &big_array->pdata[pos],
+			(src_end - pos) * sizeof(gpointer));
+		big_array->pdata[pos + inserted - 1] = small_array->pdata[i];
+		inserted--;
+		src_end = pos;
+	}
+
+	g_free(positions);
+}
+
 /*
  This function will extract the tags of the specified types from an array of tags.
  The returned value is a GPtrArray which should be free-d with a call to
@@ -110,6 +110,9 @@ typedef struct TMTag
 	char impl; /**< Implementation (e.g. virtual) */
 	TMParserType lang; /* Programming language of the file */
 	gchar kind_letter; /* Kind letter from ctags */
+	guint8 mapped; /* TRUE if the tag lives in a binary tags file mapping, which owns it */
+	guint16 arena_index; /* index + 1 in its TMTagArena block, 0 if not allocated from an arena */
+	guint32 name_mask; /* lazily computed by tm_tag_get_name_mask(), 0 if not computed yet */
 } TMTag;
 
 /* The GType for a TMTag */
@@ -119,13 +122,37 @@ GType tm_tag_get_type(void) G_GNUC_CONST;
 
 #ifdef GEANY_PRIVATE
 
+typedef struct TMTagArena TMTagArena;
+
 TMTag *tm_tag_new(void);
 
+TMTagArena *tm_tag_arena_new(void);
+
+TMTag *tm_tag_arena_new_tag(TMTagArena *arena);
+
+void tm_tag_arena_free(TMTagArena *arena);
+
+gchar *tm_tag_intern_str(const gchar *str);
+
+void tm_tag_release_str(gchar *str);
+
+void tm_tag_get_string_pool_stats(guint *count, gsize *size, gsize *saved);
+
+guint32 tm_tag_get_str_mask(const gchar *str);
+
+guint32 tm_tag_get_name_mask(TMTag *tag);
+
 void tm_tags_remove_file_tags(TMSourceFile *source_file, GPtrArray *tags_array);
 
 GPtrArray *tm_tags_merge(GPtrArray *big_array, GPtrArray *small_array,
 	TMTagAttrType *sort_attributes, gboolean unref_duplicates);
 
+GPtrArray *tm_tags_merge_sorted(GPtrArray **arrays, guint count,
+	TMTagAttrType *sort_attributes, gboolean dedup, gboolean unref_duplicates);
+
+void tm_tags_insert(GPtrArray *big_array, GPtrArray *small_array,
+	TMTagAttrType *sort_attributes, gboolean unref_duplicates);
+
 void tm_tags_sort(GPtrArray *tags_array, TMTagAttrType *sort_attributes,
 	gboolean dedup, gboolean unref_duplicates);
 
@@ -64,12 +64,90 @@ static TMTagType TM_GLOBAL_TYPE_MASK =
 static TMWorkspace *theWorkspace = NULL;
 
 
+/* A request to parse a snapshot of a source file's buffer in a background thread */
+typedef struct
+{
+	TMSourceFile *source_file;  /* reference held while the job exists */
+	GBytes *bytes;  /* the buffer to parse, released after parsing */
+	gboolean use_buffer;  /* FALSE to parse the file on disk */
+	gboolean use_cache;
+	gint cancelled;  /* atomic - set when the result is known to be stale */
+	GPtrArray *tags_array;  /* parsed tags, sorted by file_tags_sort_attrs */
+	GArray *refs;  /* reference index of the parsed file, NULL for buffers */
+	TMParseCallback callback;
+	gpointer user_data;
+} ParseJob;
+
+/* The workspace tags and the global tags split by language (TMParserType ->
+ * GPtrArray), each part sorted like the array it comes from. Autocompletion
+ * only considers tags of languages compatible with the current file so prefix
+ * lookups don't have to walk through the tags of all the other languages. */
+static GHashTable *workspace_lang_index = NULL;
+static GHashTable *global_lang_index = NULL;
+
+/* The workspace tags and the global tags with a non-empty scope grouped by the
+ * scope (scope string -> GPtrArray), each group in the order of the array it
+ * comes from, so the members of a type can be found without walking all tags */
+static GHashTable *workspace_scope_index = NULL;
+static GHashTable *global_scope_index = NULL;
+
+/* Incremented whenever the files included by workspace files may have changed,
+ * invalidating the include sets cached on the source files */
+static guint includes_stamp = 1;
+static guint include_depth = 1;
+static TMSourceFileIncludes no_includes;
+
+/* Names of the workspace typenames per language (lang -> TypenameSet) so that
+ * changes of the typenames can be detected without walking all of them */
+typedef struct
+{
+	GHashTable *names; /* interned name -> number of tags with the name */
+	guint version;
+} TypenameSet;
+
+static GHashTable *typename_sets = NULL;
+static guint typenames_version = 0;
+
+/* The tags matching the last tm_workspace_find_symbols() pattern of the
+ * workspace tags and of the global tags. Typing more characters only narrows
+ * the matches down, so the next query only needs to filter these. */
+typedef struct
+{
+	gchar *pattern;
+	guint stamp;
+	GPtrArray *tags;
+} SymbolQuery;
+
+static SymbolQuery symbol_queries[2];
+/* Incremented whenever tags are added to or removed from the workspace or
+ * global tags, invalidating symbol_queries */
+static guint symbols_stamp = 1;
+
+static GThreadPool *parse_pool = NULL;
+/* TMSourceFile -> the most recently scheduled ParseJob of the file */
+static GHashTable *parse_jobs = NULL;
+
+
 static void free_ptr_array(gpointer arr)
 {
 	g_ptr_array_free(arr, TRUE);
 }
 
 
+static void free_typename_set(gpointer data)
+{
+	TypenameSet *set = data;
+	GHashTableIter iter;
+	gpointer name;
+
+	g_hash_table_iter_init(&iter, set->names);
+	while (g_hash_table_iter_next(&iter, &name, NULL))
+		tm_tag_release_str(name);
+	g_hash_table_destroy(set->names);
+	g_free(set);
+}
+
+
 static gboolean tm_create_workspace(void)
 {
 	theWorkspace = g_new(TMWorkspace, 1);
@@ -81,6 +159,14 @@ static gboolean tm_create_workspace(void)
 	theWorkspace->global_typename_array = g_ptr_array_new();
 	theWorkspace->source_file_map = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
 		free_ptr_array);
+	parse_jobs = g_hash_table_new(NULL, NULL);
+	workspace_lang_index = g_hash_table_new_full(NULL, NULL, NULL, free_ptr_array);
+	global_lang_index = g_hash_table_new_full(NULL, NULL, NULL, free_ptr_array);
+	workspace_scope_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_ptr_array);
+	global_scope_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_ptr_array);
+	no_includes.files = g_ptr_array_new();
+	no_includes.depths = g_hash_table_new(NULL, NULL);
+	typename_sets = g_hash_table_new_full(NULL, NULL, NULL, free_typename_set);
 
 	tm_ctags_init();
 	tm_parser_verify_type_mappings();
@@ -100,6 +186,33 @@ void tm_workspace_free(void)
 	g_message("Workspace destroyed");
 #endif
 
+	/* running jobs must finish before the workspace goes away; their results
+	 * are dropped because parse_jobs no longer contains them */
+	tm_workspace_set_parse_workers(0);
+	g_hash_table_destroy(parse_jobs);
+	parse_jobs = NULL;
+	g_hash_table_destroy(workspace_lang_index);
+	workspace_lang_index = NULL;
+	g_hash_table_destroy(global_lang_index);
+	global_lang_index = NULL;
+	g_hash_table_destroy(workspace_scope_index);
+	workspace_scope_index = NULL;
+	g_hash_table_destroy(global_scope_index);
+	global_scope_index = NULL;
+	g_ptr_array_free(no_includes.files, TRUE);
+	g_hash_table_destroy(no_includes.depths);
+	no_includes.files = NULL;
+	no_includes.depths = NULL;
+	g_hash_table_destroy(typename_sets);
+	typename_sets = NULL;
+	for (i = 0; i < G_N_ELEMENTS(symbol_queries); i++)
+	{
+		g_free(symbol_queries[i].pattern);
+		if (symbol_queries[i].tags)
+			g_ptr_array_free(symbol_queries[i].tags, TRUE);
+		memset(&symbol_queries[i], 0, sizeof(SymbolQuery));
+	}
+
 	g_hash_table_destroy(theWorkspace->source_file_map);
 	for (i=0; i < theWorkspace->source_files->len; ++i)
 		tm_source_file_free(theWorkspace->source_files->pdata[i]);
@@ -108,6 +221,7 @@ void tm_workspace_free(void)
 	g_ptr_array_free(theWorkspace->tags_array, TRUE);
 	g_ptr_array_free(theWorkspace->typename_array, TRUE);
 	g_ptr_array_free(theWorkspace->global_typename_array, TRUE);
+	tm_source_file_free_binary_tags();
 	g_free(theWorkspace);
 	theWorkspace = NULL;
 }
@@ -127,16 +241,16 @@ const TMWorkspace *tm_get_workspace(void)
 }
 
 
-static void tm_workspace_merge_tags(GPtrArray **big_array, GPtrArray *small_array)
+/* Merges small_array into big_array in place so that a reparse only costs
+ * comparisons proportional to the tags of the reparsed file */
+static void tm_workspace_merge_tags(GPtrArray *big_array, GPtrArray *small_array)
 {
-	GPtrArray *new_tags = tm_tags_merge(*big_array, small_array, workspace_tags_sort_attrs, FALSE);
-	/* tags owned by TMSourceFile - free just the pointer array */
-	g_ptr_array_free(*big_array, TRUE);
-	*big_array = new_tags;
+	/* tags owned by TMSourceFile - nothing to unref */
+	tm_tags_insert(big_array, small_array, workspace_tags_sort_attrs, FALSE);
 }
 
 
-static void merge_extracted_tags(GPtrArray **dest, GPtrArray *src, TMTagType tag_types)
+static void merge_extracted_tags(GPtrArray *dest, GPtrArray *src, TMTagType tag_types)
 {
 	GPtrArray *arr;
 
@@ -146,30 +260,282 @@ static void merge_extracted_tags(GPtrArray **dest, GPtrArray *src, TMTagType tag
 }
 
 
+/* Rebuilds the language index from a sorted tags array */
+static void fill_lang_index(GHashTable *lang_index, GPtrArray *tags)
+{
+	GPtrArray *lang_tags = NULL;
+	TMParserType lang = TM_PARSER_NONE;
+	guint i;
+
+	g_hash_table_remove_all(lang_index);
+	for (i = 0; i < tags->len; i++)
+	{
+		TMTag *tag = tags->pdata[i];
+
+		if (!lang_tags || tag->lang != lang)
+		{
+			lang = tag->lang;
+			lang_tags = g_hash_table_lookup(lang_index, GINT_TO_POINTER(lang));
+			if (!lang_tags)
+			{
+				lang_tags = g_ptr_array_new();
+				g_hash_table_insert(lang_index, GINT_TO_POINTER(lang), lang_tags);
+			}
+		}
+		g_ptr_array_add(lang_tags, tag);
+	}
+}
+
+
+/* Groups the tags with a scope by the scope, keeping their order */
+static void group_by_scope(GHashTable *scope_index, GPtrArray *tags)
+{
+	guint i;
+
+	for (i = 0; i < tags->len; i++)
+	{
+		TMTag *tag = tags->pdata[i];
+		GPtrArray *scope_tags;
+
+		if (!tag->scope || !*tag->scope)
+			continue;
+
+		scope_tags = g_hash_table_lookup(scope_index, tag->scope);
+		if (!scope_tags)
+		{
+			scope_tags = g_ptr_array_new();
+			g_hash_table_insert(scope_index, g_strdup(tag->scope), scope_tags);
+		}
+		g_ptr_array_add(scope_tags, tag);
+	}
+}
+
+
+/* Rebuilds the scope index from a sorted tags array */
+static void fill_scope_index(GHashTable *scope_index, GPtrArray *tags)
+{
+	g_hash_table_remove_all(scope_index);
+	group_by_scope(scope_index, tags);
+}
+
+
+static void remove_scope_index_file_tags(TMSourceFile *source_file)
+{
+	GHashTable *file_scopes = g_hash_table_new(g_str_hash, g_str_equal);
+	GHashTableIter iter;
+	gpointer key;
+	guint i;
+
+	for (i = 0; i < source_file->tags_array->len; i++)
+	{
+		TMTag *tag = source_file->tags_array->pdata[i];
+
+		if (tag->scope && *tag->scope)
+			g_hash_table_add(file_scopes, tag->scope);
+	}
+
+	g_hash_table_iter_init(&iter, file_scopes);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+	{
+		GPtrArray *scope_tags = g_hash_table_lookup(workspace_scope_index, key);
+
+		if (!scope_tags)
+			continue;
+		for (i = 0; i < scope_tags->len; i++)
+		{
+			if (TM_TAG(scope_tags->pdata[i])->file == source_file)
+				scope_tags->pdata[i] = NULL;
+		}
+		tm_tags_prune(scope_tags);
+		if (scope_tags->len == 0)
+			g_hash_table_remove(workspace_scope_index, key);
+	}
+
+	g_hash_table_destroy(file_scopes);
+}
+
+
+static void merge_scope_index_file_tags(TMSourceFile *source_file)
+{
+	GHashTable *file_scopes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_ptr_array);
+	GHashTableIter iter;
+	gpointer key, value;
+
+	group_by_scope(file_scopes, source_file->tags_array);
+
+	g_hash_table_iter_init(&iter, file_scopes);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		GPtrArray *scope_tags = g_hash_table_lookup(workspace_scope_index, key);
+
+		if (scope_tags)
+			tm_workspace_merge_tags(scope_tags, value);
+		else
+			g_hash_table_insert(workspace_scope_index, g_strdup(key),
+				tm_tags_extract(value, tm_tag_max_t));
+	}
+
+	g_hash_table_destroy(file_scopes);
+}
+
+
+/* Adds or removes the names of the typenames among tags to/from the typename
+ * sets. The version of a set only changes when a name is added to or removed
+ * from it, not when just the number of tags with the name changes. */
+static void update_typename_sets(GPtrArray *tags, gboolean add)
+{
+	guint i;
+
+	for (i = 0; i < tags->len; i++)
+	{
+		TMTag *tag = tags->pdata[i];
+		gpointer key = GINT_TO_POINTER(tag->lang);
+		TypenameSet *set;
+		gpointer name, count;
+
+		if (!(tag->type & TM_GLOBAL_TYPE_MASK) || !tag->name)
+			continue;
+
+		set = g_hash_table_lookup(typename_sets, key);
+		if (!set)
+		{
+			if (!add)
+				continue;
+			set = g_new0(TypenameSet, 1);
+			set->names = g_hash_table_new(g_str_hash, g_str_equal);
+			g_hash_table_insert(typename_sets, key, set);
+		}
+
+		if (!g_hash_table_lookup_extended(set->names, tag->name, &name, &count))
+		{
+			if (!add)
+				continue;
+			g_hash_table_insert(set->names, tm_tag_intern_str(tag->name), GUINT_TO_POINTER(1));
+			set->version = ++typenames_version;
+		}
+		else if (add)
+			g_hash_table_insert(set->names, name, GUINT_TO_POINTER(GPOINTER_TO_UINT(count) + 1));
+		else if (GPOINTER_TO_UINT(count) > 1)
+			g_hash_table_insert(set->names, name, GUINT_TO_POINTER(GPOINTER_TO_UINT(count) - 1));
+		else
+		{
+			g_hash_table_remove(set->names, name);
+			tm_tag_release_str(name);
+			set->version = ++typenames_version;
+		}
+	}
+}
+
+
+/* Removes the tags of source_file from the workspace tag arrays. Must be called
+ * while source_file still contains the tags to be removed. */
+static void remove_file_tags(TMSourceFile *source_file)
+{
+	GPtrArray *lang_tags;
+
+	tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
+	tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
+
+	/* all tags of a file have the language of the file */
+	lang_tags = g_hash_table_lookup(workspace_lang_index, GINT_TO_POINTER(source_file->lang));
+	if (lang_tags)
+		tm_tags_remove_file_tags(source_file, lang_tags);
+
+	remove_scope_index_file_tags(source_file);
+	update_typename_sets(source_file->tags_array, FALSE);
+	symbols_stamp++;
+}
+
+
+/* Invalidates the cached include sets when the includes of source_file changed */
+static void update_includes_signature(TMSourceFile *source_file)
+{
+	TMSourceFileIncludes *includes = tm_source_file_get_includes(source_file);
+	guint signature = 0;
+	guint i;
+
+	if (source_file->lang != TM_PARSER_C && source_file->lang != TM_PARSER_CPP)
+		return;
+
+	for (i = 0; i < source_file->tags_array->len; i++)
+	{
+		TMTag *tag = source_file->tags_array->pdata[i];
+
+		if (tag->type & tm_tag_include_t)
+			signature = signature * 31 + g_str_hash(tag->name);
+	}
+
+	if (signature != includes->signature)
+	{
+		includes->signature = signature;
+		includes_stamp++;
+	}
+}
+
+
+/* Merges the (sorted) tags of source_file into the workspace tag arrays */
+static void merge_file_tags(TMSourceFile *source_file)
+{
+	GPtrArray *lang_tags;
+	gpointer key = GINT_TO_POINTER(source_file->lang);
+
+	update_includes_signature(source_file);
+	update_typename_sets(source_file->tags_array, TRUE);
+	symbols_stamp++;
+	tm_workspace_merge_tags(theWorkspace->tags_array, source_file->tags_array);
+	merge_extracted_tags(theWorkspace->typename_array, source_file->tags_array, TM_GLOBAL_TYPE_MASK);
+
+	if (source_file->tags_array->len == 0)
+		return;
+	merge_scope_index_file_tags(source_file);
+
+	lang_tags = g_hash_table_lookup(workspace_lang_index, key);
+	if (lang_tags)
+		tm_workspace_merge_tags(lang_tags, source_file->tags_array);
+	else
+		g_hash_table_insert(workspace_lang_index, key,
+			tm_tags_extract(source_file->tags_array, tm_tag_max_t));
+}
+
+
+static void cancel_parse_job(TMSourceFile *source_file)
+{
+	ParseJob *job = g_hash_table_lookup(parse_jobs, source_file);
+
+	if (job)
+	{
+		g_atomic_int_set(&job->cancelled, TRUE);
+		g_hash_table_remove(parse_jobs, source_file);
+	}
+}
+
+
 static void update_source_file(TMSourceFile *source_file, guchar* text_buf,
-	gsize buf_size, gboolean use_buffer, gboolean update_workspace)
+	gsize buf_size, gboolean use_buffer, gboolean use_cache, gboolean index_refs,
+	gboolean update_workspace)
 {
 #ifdef TM_DEBUG
 	g_message("Source file updating based on source file %s", source_file->file_name);
 #endif
 
+	/* results of a running background parse would be older than ours */
+	if (parse_jobs)
+		cancel_parse_job(source_file);
+
 	if (update_workspace)
 	{
 		/* tm_source_file_parse() deletes the tag objects - remove the tags from
 		 * workspace while they exist and can be scanned */
-		tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
-		tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
+		remove_file_tags(source_file);
 	}
-	tm_source_file_parse(source_file, text_buf, buf_size, use_buffer);
+	tm_source_file_parse(source_file, text_buf, buf_size, use_buffer, use_cache, index_refs);
 	tm_tags_sort(source_file->tags_array, file_tags_sort_attrs, FALSE, TRUE);
 	if (update_workspace)
 	{
 #ifdef TM_DEBUG
 		g_message("Updating workspace from source file");
 #endif
-		tm_workspace_merge_tags(&theWorkspace->tags_array, source_file->tags_array);
-
-		merge_extracted_tags(&(theWorkspace->typename_array), source_file->tags_array, TM_GLOBAL_TYPE_MASK);
+		merge_file_tags(source_file);
 	}
 #ifdef TM_DEBUG
 	else
@@ -195,6 +561,7 @@ void tm_workspace_add_source_file_noupdate(TMSourceFile *source_file)
 		g_hash_table_insert(theWorkspace->source_file_map, g_strdup(source_file->short_name), file_arr);
 	}
 	g_ptr_array_add(file_arr, source_file);
+	includes_stamp++;
 }
 
 
@@ -207,7 +574,7 @@ void tm_workspace_add_source_file(TMSourceFile *source_file)
 	g_return_if_fail(source_file != NULL);
 
 	tm_workspace_add_source_file_noupdate(source_file);
-	update_source_file(source_file, NULL, 0, FALSE, TRUE);
+	update_source_file(source_file, NULL, 0, FALSE, TRUE, TRUE, TRUE);
 }
 
 
@@ -226,7 +593,189 @@ void tm_workspace_add_source_file(TMSourceFile *source_file)
 void tm_workspace_update_source_file_buffer(TMSourceFile *source_file, guchar* text_buf,
 	gsize buf_size)
 {
-	update_source_file(source_file, text_buf, buf_size, TRUE, TRUE);
+	update_source_file(source_file, text_buf, buf_size, TRUE, FALSE, FALSE, TRUE);
+}
+
+
+static void parse_job_free(ParseJob *job)
+{
+	if (job->tags_array)
+		tm_tags_array_free(job->tags_array, TRUE);
+	if (job->refs)
+		g_array_free(job->refs, TRUE);
+	tm_source_file_free(job->source_file);
+	if (job->bytes)
+		g_bytes_unref(job->bytes);
+	g_free(job);
+}
+
+
+/* runs in the main loop; replaces the tags of the source file with the parsed ones
+ * unless the result became stale in the meantime */
+static gboolean parse_job_finish(gpointer data)
+{
+	ParseJob *job = data;
+	TMSourceFile *source_file = job->source_file;
+
+	if (parse_jobs && !g_atomic_int_get(&job->cancelled) &&
+		g_hash_table_lookup(parse_jobs, source_file) == job)
+	{
+		guint i;
+
+		g_hash_table_remove(parse_jobs, source_file);
+
+		remove_file_tags(source_file);
+
+		tm_tags_array_free(source_file->tags_array, FALSE);
+		for (i = 0; i < job->tags_array->len; i++)
+			g_ptr_array_add(source_file->tags_array, job->tags_array->pdata[i]);
+		/* tags are now owned by source_file */
+		g_ptr_array_set_size(job->tags_array, 0);
+		tm_source_file_set_refs(source_file, job->refs);
+		job->refs = NULL;
+
+		merge_file_tags(source_file);
+
+		if (job->callback)
+			job->callback(source_file, job->user_data);
+	}
+#ifdef TM_DEBUG
+	else
+		g_message("Dropping stale parse result of %s", source_file->file_name);
+#endif
+
+	parse_job_free(job);
+	return FALSE;
+}
+
+
+/* runs in a parser thread */
+static void parse_job_run(gpointer data, gpointer user_data)
+{
+	ParseJob *job = data;
+	TMSourceFile *source_file = job->source_file;
+
+	if (!g_atomic_int_get(&job->cancelled) && (!job->use_buffer || job->bytes))
+	{
+		gsize buf_size = 0;
+		const guchar *text_buf = job->bytes ? g_bytes_get_data(job->bytes, &buf_size) : NULL;
+
+		/* the buffer isn't modified by parsing; buffers are of open documents,
+		 * which are searched directly instead of through the reference index */
+		tm_source_file_parse_tags(source_file, (guchar *) text_buf, buf_size,
+			job->use_buffer, job->use_cache, job->tags_array,
+			job->use_buffer ? NULL : &job->refs, &job->cancelled);
+		tm_tags_sort(job->tags_array, file_tags_sort_attrs, FALSE, TRUE);
+	}
+
+	if (job->bytes)
+	{
+		g_bytes_unref(job->bytes);
+		job->bytes = NULL;
+	}
+
+	g_idle_add(parse_job_finish, job);
+}
+
+
+/* Sets the number of threads parsing source files in the background. Note that
+ ctags itself can only run one parse at a time so additional workers only help
+ with the preparation and sorting of the results. With 0 workers, all parsing
+ happens synchronously in the calling thread. Waits for running parses to finish.
+ @param num_workers The number of parser threads.
+*/
+void tm_workspace_set_parse_workers(guint num_workers)
+{
+	if (parse_pool && num_workers > 0)
+	{
+		g_thread_pool_set_max_threads(parse_pool, (gint) num_workers, NULL);
+		return;
+	}
+
+	if (parse_pool)
+	{
+		GHashTableIter iter;
+		gpointer job;
+
+		/* let the queued jobs finish quickly without parsing */
+		g_hash_table_iter_init(&iter, parse_jobs);
+		while (g_hash_table_iter_next(&iter, NULL, &job))
+			g_atomic_int_set(&((ParseJob *) job)->cancelled, TRUE);
+		g_hash_table_remove_all(parse_jobs);
+
+		g_thread_pool_free(parse_pool, FALSE, TRUE);
+		parse_pool = NULL;
+	}
+
+	if (num_workers > 0)
+		parse_pool = g_thread_pool_new(parse_job_run, NULL, (gint) num_workers, FALSE, NULL);
+}
+
+
+static void schedule_parse_job(TMSourceFile *source_file, GBytes *bytes,
+	gboolean use_buffer, gboolean use_cache, TMParseCallback callback, gpointer user_data)
+{
+	ParseJob *job;
+
+	cancel_parse_job(source_file);
+
+	job = g_new0(ParseJob, 1);
+	job->source_file = tm_source_file_dup(source_file);
+	job->use_buffer = use_buffer;
+	job->use_cache = use_cache;
+	if (use_buffer && bytes && g_bytes_get_size(bytes) > 0)
+		job->bytes = g_bytes_ref(bytes);
+	job->tags_array = g_ptr_array_new();
+	job->callback = callback;
+	job->user_data = user_data;
+
+	g_hash_table_insert(parse_jobs, source_file, job);
+	g_thread_pool_push(parse_pool, job, NULL);
+}
+
+
+/* Whether tm_workspace_update_source_file_buffer_async() parses source_file in a
+ background thread. Otherwise it parses synchronously and doesn't keep any
+ reference to the passed contents.
+ @param source_file The source file.
+ @return TRUE if the file is parsed in the background. */
+gboolean tm_workspace_parses_in_background(TMSourceFile *source_file)
+{
+	return parse_pool && source_file->lang != TM_PARSER_NONE;
+}
+
+
+/* Like tm_workspace_update_source_file_buffer() but parses bytes in a background
+ thread and updates the workspace from the main loop once parsing finishes.
+ Results of a parse are dropped when the source file is reparsed or removed from
+ the workspace before they arrive. When no parse workers are set, the update
+ happens immediately.
+ @param source_file The source file to update with a buffer.
+ @param bytes The contents to parse; a reference is kept until parsing finishes
+ so they must not be modified.
+ @param use_cache Whether bytes correspond to the file on disk so its tags
+ can be loaded from and stored to the tag cache.
+ @param callback Function called after the workspace has been updated, or NULL.
+ @param user_data User data passed to callback.
+*/
+void tm_workspace_update_source_file_buffer_async(TMSourceFile *source_file,
+	GBytes *bytes, gboolean use_cache, TMParseCallback callback, gpointer user_data)
+{
+	g_return_if_fail(source_file != NULL);
+	g_return_if_fail(bytes != NULL);
+
+	if (!tm_workspace_parses_in_background(source_file))
+	{
+		gsize buf_size;
+		const guchar *text_buf = g_bytes_get_data(bytes, &buf_size);
+
+		update_source_file(source_file, (guchar *) text_buf, buf_size, TRUE, use_cache, FALSE,
+			TRUE);
+		if (callback)
+			callback(source_file, user_data);
+	}
+	else
+		schedule_parse_job(source_file, bytes, TRUE, use_cache, callback, user_data);
 }
 
 
@@ -236,6 +785,7 @@ static void remove_source_file_map(TMSourceFile *source_file)
 
 	if (file_arr)
 		g_ptr_array_remove_fast(file_arr, source_file);
+	includes_stamp++;
 }
 
 
@@ -255,8 +805,8 @@ void tm_workspace_remove_source_file(TMSourceFile *source_file)
 	{
 		if (theWorkspace->source_files->pdata[i] == source_file)
 		{
-			tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
-			tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
+			cancel_parse_job(source_file);
+			remove_file_tags(source_file);
 			remove_source_file_map(source_file);
 			g_ptr_array_remove_index_fast(theWorkspace->source_files, i);
 			return;
@@ -270,7 +820,7 @@ void tm_workspace_remove_source_file(TMSourceFile *source_file)
  which should be called before this function on source files which need to be
  reparsed.
 */
-static void tm_workspace_update(void)
+void tm_workspace_update(void)
 {
 	guint i, j;
 	TMSourceFile *source_file;
@@ -290,6 +840,7 @@ static void tm_workspace_update(void)
 #ifdef TM_DEBUG
 		g_message("Adding tags of %s", source_file->file_name);
 #endif
+		update_includes_signature(source_file);
 		if (source_file->tags_array->len > 0)
 		{
 			for (j = 0; j < source_file->tags_array->len; ++j)
@@ -306,6 +857,40 @@ static void tm_workspace_update(void)
 
 	g_ptr_array_free(theWorkspace->typename_array, TRUE);
 	theWorkspace->typename_array = tm_tags_extract(theWorkspace->tags_array, TM_GLOBAL_TYPE_MASK);
+
+	/* from the file arrays to count the tags like remove_file_tags() does */
+	g_hash_table_remove_all(typename_sets);
+	for (i = 0; i < theWorkspace->source_files->len; i++)
+	{
+		source_file = theWorkspace->source_files->pdata[i];
+		update_typename_sets(source_file->tags_array, TRUE);
+	}
+
+	fill_lang_index(workspace_lang_index, theWorkspace->tags_array);
+	fill_scope_index(workspace_scope_index, theWorkspace->tags_array);
+	symbols_stamp++;
+}
+
+
+/* Gets the version of the workspace typenames usable in files of the given
+ language. The version changes whenever a typename is added or removed.
+ @param lang The language of the file.
+ @return The version, 0 if there never were any typenames for the language. */
+guint tm_workspace_get_typenames_version(TMParserType lang)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	guint version = 0;
+
+	g_hash_table_iter_init(&iter, typename_sets);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		TypenameSet *set = value;
+
+		if (tm_parser_langs_compatible(lang, GPOINTER_TO_INT(key)))
+			version = MAX(version, set->version);
+	}
+	return version;
 }
 
 
@@ -326,13 +911,51 @@ void tm_workspace_add_source_files(GPtrArray *source_files)
 		TMSourceFile *source_file = source_files->pdata[i];
 
 		tm_workspace_add_source_file_noupdate(source_file);
-		update_source_file(source_file, NULL, 0, FALSE, FALSE);
+		update_source_file(source_file, NULL, 0, FALSE, TRUE, TRUE, FALSE);
 	}
 
 	tm_workspace_update();
 }
 
 
+/* Like tm_workspace_add_source_files() but when background parsing is enabled,
+ the files are parsed in parser threads and their tags appear in the workspace
+ once parsing finishes.
+ @param source_files @elementtype{TMSourceFile} The source files to be added to the workspace.
+ @param update Whether to update the workspace tag arrays with the files parsed
+ synchronously. Pass FALSE when adding files in several batches and call
+ tm_workspace_update() after the last one.
+ @return TRUE if files were parsed synchronously without updating the workspace.
+*/
+gboolean tm_workspace_add_source_files_async(GPtrArray *source_files, gboolean update)
+{
+	gboolean parsed = FALSE;
+	guint i;
+
+	g_return_val_if_fail(source_files != NULL, FALSE);
+
+	for (i = 0; i < source_files->len; i++)
+	{
+		TMSourceFile *source_file = source_files->pdata[i];
+
+		tm_workspace_add_source_file_noupdate(source_file);
+		if (parse_pool && source_file->lang != TM_PARSER_NONE)
+			schedule_parse_job(source_file, NULL, FALSE, TRUE, NULL, NULL);
+		else
+		{
+			update_source_file(source_file, NULL, 0, FALSE, TRUE, TRUE, FALSE);
+			parsed = TRUE;
+		}
+	}
+
+	/* files parsed in the background merge their tags when done so there is
+	 * nothing to rebuild for them yet */
+	if (parsed && update)
+		tm_workspace_update();
+	return parsed && !update;
+}
+
+
 /** Removes multiple source files from the workspace and updates the workspace tag
  arrays. This is more efficient than calling tm_workspace_remove_source_file()
  separately for each of the files. To completely free the TMSourceFile pointers
@@ -355,6 +978,7 @@ void tm_workspace_remove_source_files(GPtrArray *source_files)
 		{
 			if (theWorkspace->source_files->pdata[j] == source_file)
 			{
+				cancel_parse_job(source_file);
 				remove_source_file_map(source_file);
 				g_ptr_array_remove_index_fast(theWorkspace->source_files, j);
 				break;
@@ -368,31 +992,117 @@ void tm_workspace_remove_source_files(GPtrArray *source_files)
 
 /* Loads the global tag list from the specified file. The global tag list should
  have been first created using tm_workspace_create_global_tags().
+ Files in the binary format are mapped and are already sorted, so they are only
+ merged into the global tags.
  @param tags_file The file containing global tags.
  @return TRUE on success, FALSE on failure.
  @see tm_workspace_create_global_tags()
 */
 gboolean tm_workspace_load_global_tags(const char *tags_file, TMParserType mode)
 {
-	GPtrArray *file_tags, *new_tags;
+	return tm_workspace_load_global_tags_files(&tags_file, &mode, 1, NULL) == 1;
+}
 
-	file_tags = tm_source_file_read_tags_file(tags_file, mode);
-	if (!file_tags)
-		return FALSE;
 
-	tm_tags_sort(file_tags, global_tags_sort_attrs, TRUE, TRUE);
+typedef struct
+{
+	const gchar *tags_file;
+	TMParserType mode;
+	GPtrArray *tags;
+	GError *error;  /* reported by the main thread, the log handlers aren't thread-safe */
+} GlobalTagsRead;
 
-	/* reorder the whole array, because tm_tags_find expects a sorted array */
-	new_tags = tm_tags_merge(theWorkspace->global_tags,
-		file_tags, global_tags_sort_attrs, TRUE);
-	g_ptr_array_free(theWorkspace->global_tags, TRUE);
-	g_ptr_array_free(file_tags, TRUE);
-	theWorkspace->global_tags = new_tags;
 
-	g_ptr_array_free(theWorkspace->global_typename_array, TRUE);
-	theWorkspace->global_typename_array = tm_tags_extract(new_tags, TM_GLOBAL_TYPE_MASK);
+/* may run in a separate thread */
+static gpointer read_global_tags(gpointer data)
+{
+	GlobalTagsRead *read = data;
+	gboolean sorted;
 
-	return TRUE;
+	read->tags = tm_source_file_read_tags_file(read->tags_file, read->mode, &sorted, &read->error);
+	if (read->tags && !sorted)
+		tm_tags_sort(read->tags, global_tags_sort_attrs, TRUE, TRUE);
+	return NULL;
+}
+
+
+/* Loads several global tags files at once. The files are read and sorted in
+ parallel and merged into the global tags in a single k-way merge, after which
+ the global typenames and indexes are rebuilt once.
+ @param tags_files The files containing global tags.
+ @param modes The languages of the tags of each file.
+ @param count The number of files.
+ @param tag_counts Location to store the number of tags read from each file
+ (-1 if the file couldn't be read), or NULL.
+ @return The number of loaded files.
+ @see tm_workspace_load_global_tags()
+*/
+guint tm_workspace_load_global_tags_files(const gchar **tags_files, const TMParserType *modes,
+	guint count, gint *tag_counts)
+{
+	GlobalTagsRead *reads = g_new0(GlobalTagsRead, count);
+	GThread **threads = g_new0(GThread *, count);
+	GPtrArray *arrays = g_ptr_array_new();
+	GPtrArray *new_tags;
+	guint i, loaded = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		reads[i].tags_file = tags_files[i];
+		reads[i].mode = modes[i];
+	}
+	/* the last file is read by this thread */
+	for (i = 0; i + 1 < count; i++)
+	{
+		threads[i] = g_thread_try_new("tm-load-tags", read_global_tags, &reads[i], NULL);
+		if (!threads[i])
+			read_global_tags(&reads[i]);
+	}
+	if (count > 0)
+		read_global_tags(&reads[count - 1]);
+
+	/* the existing global tags come first so that equal tags from the new files
+	 * replace them */
+	g_ptr_array_add(arrays, theWorkspace->global_tags);
+	for (i = 0; i < count; i++)
+	{
+		if (threads[i])
+			g_thread_join(threads[i]);
+		if (reads[i].error)
+		{
+			g_warning("%s", reads[i].error->message);
+			g_error_free(reads[i].error);
+		}
+		if (tag_counts)
+			tag_counts[i] = reads[i].tags ? (gint) reads[i].tags->len : -1;
+		if (reads[i].tags)
+		{
+			g_ptr_array_add(arrays, reads[i].tags);
+			loaded++;
+		}
+	}
+
+	if (loaded > 0)
+	{
+		/* reorder the whole array, because tm_tags_find expects a sorted array */
+		new_tags = tm_tags_merge_sorted((GPtrArray **) arrays->pdata, arrays->len,
+			global_tags_sort_attrs, TRUE, TRUE);
+		for (i = 0; i < arrays->len; i++)
+			g_ptr_array_free(arrays->pdata[i], TRUE);
+		theWorkspace->global_tags = new_tags;
+
+		g_ptr_array_free(theWorkspace->global_typename_array, TRUE);
+		theWorkspace->global_typename_array = tm_tags_extract(new_tags, TM_GLOBAL_TYPE_MASK);
+
+		fill_lang_index(global_lang_index, new_tags);
+		fill_scope_index(global_scope_index, new_tags);
+		symbols_stamp++;
+	}
+
+	g_ptr_array_free(arrays, TRUE);
+	g_free(threads);
+	g_free(reads);
+	return loaded;
 }
 
 
@@ -499,8 +1209,15 @@ static gchar *pre_process_file(const gchar *cmd, const gchar *inf)
 	return outf;
 }
 
+static gboolean write_global_tags_file(const char *tags_file, GPtrArray *tags, gboolean binary)
+{
+	if (binary)
+		return tm_source_file_write_binary_tags_file(tags_file, tags);
+	return tm_source_file_write_tags_file(tags_file, tags);
+}
+
 static gboolean create_global_tags_preprocessed(const char *pre_process_cmd,
-	GList *source_files, const char *tags_file, TMParserType lang)
+	GList *source_files, const char *tags_file, TMParserType lang, gboolean binary)
 {
 	TMSourceFile *source_file;
 	gboolean ret = FALSE;
@@ -532,7 +1249,7 @@ static gboolean create_global_tags_preprocessed(const char *pre_process_cmd,
 	source_file = tm_source_file_new(temp_file, tm_source_file_get_lang_name(lang));
 	if (!source_file)
 		goto cleanup;
-	update_source_file(source_file, NULL, 0, FALSE, FALSE);
+	update_source_file(source_file, NULL, 0, FALSE, FALSE, FALSE, FALSE);
 	if (source_file->tags_array->len == 0)
 	{
 		tm_source_file_free(source_file);
@@ -541,7 +1258,7 @@ static gboolean create_global_tags_preprocessed(const char *pre_process_cmd,
 
 	tm_tags_sort(source_file->tags_array, global_tags_sort_attrs, TRUE, FALSE);
 	filtered_tags = tm_tags_extract(source_file->tags_array, ~(tm_tag_local_var_t | tm_tag_include_t));
-	ret = tm_source_file_write_tags_file(tags_file, filtered_tags);
+	ret = write_global_tags_file(tags_file, filtered_tags, binary);
 	g_ptr_array_free(filtered_tags, TRUE);
 	tm_source_file_free(source_file);
 
@@ -552,7 +1269,7 @@ cleanup:
 }
 
 static gboolean create_global_tags_direct(GList *source_files, const char *tags_file,
-	TMParserType lang)
+	TMParserType lang, gboolean binary)
 {
 	GList *node;
 	GPtrArray *filtered_tags;
@@ -567,7 +1284,7 @@ static gboolean create_global_tags_direct(GList *source_files, const char *tags_
 		{
 			guint i;
 			tm_source_files = g_slist_prepend(tm_source_files, source_file);
-			tm_source_file_parse(source_file, NULL, 0, FALSE);
+			tm_source_file_parse(source_file, NULL, 0, FALSE, FALSE, FALSE);
 			for (i = 0; i < source_file->tags_array->len; i++)
 				g_ptr_array_add(tags, source_file->tags_array->pdata[i]);
 		}
@@ -577,7 +1294,7 @@ static gboolean create_global_tags_direct(GList *source_files, const char *tags_
 	tm_tags_sort(filtered_tags, global_tags_sort_attrs, TRUE, FALSE);
 
 	if (filtered_tags->len > 0)
-		ret = tm_source_file_write_tags_file(tags_file, filtered_tags);
+		ret = write_global_tags_file(tags_file, filtered_tags, binary);
 
 	g_ptr_array_free(tags, TRUE);
 	g_ptr_array_free(filtered_tags, TRUE);
@@ -586,6 +1303,78 @@ static gboolean create_global_tags_direct(GList *source_files, const char *tags_
 	return ret;
 }
 
+/* Reads existing tags files (in any format) and writes their tags to a single file.
+ * If all files are sorted (binary format, e.g. the shards of a parallel tags
+ * generation), they are k-way merged, which gives the same result as sorting
+ * their concatenation. */
+static gboolean convert_global_tags(GList *source_files, const char *tags_file,
+	TMParserType lang, gboolean binary)
+{
+	GList *node;
+	GPtrArray *file_arrays = g_ptr_array_new_with_free_func(free_ptr_array);
+	GPtrArray *tags;
+	gboolean all_sorted = TRUE;
+	gboolean ret = FALSE;
+
+	for (node = source_files; node; node = node->next)
+	{
+		gboolean sorted;
+		GError *error = NULL;
+		GPtrArray *file_tags = tm_source_file_read_tags_file(node->data, lang, &sorted, &error);
+
+		if (!file_tags)
+		{
+			if (error)
+			{
+				g_printerr("%s\n", error->message);
+				g_error_free(error);
+			}
+			else
+				g_printerr("Failed to read tags file %s\n", (gchar *) node->data);
+			continue;
+		}
+		all_sorted = all_sorted && sorted;
+		g_ptr_array_add(file_arrays, file_tags);
+	}
+
+	if (all_sorted)
+		tags = tm_tags_merge_sorted((GPtrArray **) file_arrays->pdata, file_arrays->len,
+			global_tags_sort_attrs, TRUE, TRUE);
+	else
+	{
+		guint i, j;
+
+		tags = g_ptr_array_new();
+		for (i = 0; i < file_arrays->len; i++)
+		{
+			GPtrArray *file_tags = file_arrays->pdata[i];
+
+			for (j = 0; j < file_tags->len; j++)
+				g_ptr_array_add(tags, file_tags->pdata[j]);
+		}
+		tm_tags_sort(tags, global_tags_sort_attrs, TRUE, TRUE);
+	}
+	g_ptr_array_free(file_arrays, TRUE);
+
+	if (tags->len > 0)
+		ret = write_global_tags_file(tags_file, tags, binary);
+
+	tm_tags_array_free(tags, TRUE);
+	return ret;
+}
+
+static gboolean are_tags_files(GList *source_files)
+{
+	GList *node;
+
+	for (node = source_files; node; node = node->next)
+	{
+		if (! g_str_has_suffix(node->data, ".tags"))
+			return FALSE;
+	}
+	return source_files != NULL;
+}
+
 /* Creates a list of global tags. Ideally, this should be created once during
  installations so that all users can use the same file. This is because a full
  scale global tag list can occupy several megabytes of disk space.
@@ -593,20 +1382,24 @@ static gboolean create_global_tags_direct(GList *source_files, const char *tags_
  so you can pass stuff like 'gcc -E -dD -P `gnome-config --cflags gnome`'.
  @param sources Source files to process. Wildcards such as '/usr/include/a*.h'
  are allowed.
+ If all sources are tags files, they are converted instead of parsed.
  @param tags_file The file where the tags will be stored.
  @param lang The language to use for the tags file.
+ @param binary Whether to write the tags file in the binary format.
  @return TRUE on success, FALSE on failure.
 */
 gboolean tm_workspace_create_global_tags(const char *pre_process_cmd, const char **sources,
-	int sources_count, const char *tags_file, TMParserType lang)
+	int sources_count, const char *tags_file, TMParserType lang, gboolean binary)
 {
 	gboolean ret = FALSE;
 	GList *source_files = lookup_sources(sources, sources_count);
 
-	if (pre_process_cmd)
-		ret = create_global_tags_preprocessed(pre_process_cmd, source_files, tags_file, lang);
+	if (are_tags_files(source_files))
+		ret = convert_global_tags(source_files, tags_file, lang, binary);
+	else if (pre_process_cmd)
+		ret = create_global_tags_preprocessed(pre_process_cmd, source_files, tags_file, lang, binary);
 	else
-		ret = create_global_tags_direct(source_files, tags_file, lang);
+		ret = create_global_tags_direct(source_files, tags_file, lang, binary);
 
 	g_list_free_full(source_files, g_free);
 	return ret;
@@ -686,6 +1479,7 @@ typedef struct
 	TMSourceFile *file;
 	GPtrArray *header_candidates;
 	GHashTable *includes;
+	GPtrArray *include_files;
 	guint line;
 	const gchar *scope;
 } CopyInfo;
@@ -738,6 +1532,73 @@ static void copy_tags(GPtrArray *dst, TMTag **src, guint src_len, GHashTable *na
 }
 
 
+typedef struct
+{
+	TMTag **pos;
+	TMTag **end;
+} TagRange;
+
+/* Like copy_tags() for all tags starting with prefix from the parts of lang_index
+ * compatible with the current file. The names are visited in sorted order across
+ * the parts and all tags of an already used name are skipped at once. */
+static void copy_lang_index_tags(GPtrArray *dst, GHashTable *lang_index, const char *prefix,
+	GHashTable *name_table, guint max_num, gboolean (*predicate) (TMTag *, CopyInfo *),
+	CopyInfo *info)
+{
+	TMParserType lang = info->file ? info->file->lang : TM_PARSER_NONE;
+	GArray *ranges = g_array_new(FALSE, FALSE, sizeof(TagRange));
+	GHashTableIter iter;
+	gpointer key, value;
+
+	g_hash_table_iter_init(&iter, lang_index);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		TagRange range;
+		guint count;
+
+		if (!tm_parser_langs_compatible(lang, GPOINTER_TO_INT(key)))
+			continue;
+		range.pos = tm_tags_find(value, prefix, TRUE, &count);
+		if (range.pos)
+		{
+			range.end = range.pos + count;
+			g_array_append_val(ranges, range);
+		}
+	}
+
+	while (dst->len < max_num)
+	{
+		TagRange *range = NULL;
+		TMTag **name_end;
+		const gchar *name;
+		guint i;
+
+		/* the range with the smallest next name */
+		for (i = 0; i < ranges->len; i++)
+		{
+			TagRange *r = &g_array_index(ranges, TagRange, i);
+			if (r->pos < r->end && (!range || strcmp((*r->pos)->name, (*range->pos)->name) < 0))
+				range = r;
+		}
+		if (!range)
+			break;
+
+		name = (*range->pos)->name;
+		name_end = range->pos;
+		while (name_end < range->end &&
+			((*name_end)->name == name || strcmp((*name_end)->name, name) == 0))
+			name_end++;
+
+		if (!g_hash_table_contains(name_table, name))
+			copy_tags(dst, range->pos, name_end - range->pos, name_table, max_num - dst->len,
+				predicate, info);
+		range->pos = name_end;
+	}
+
+	g_array_free(ranges, TRUE);
+}
+
+
 static void fill_find_tags_array_prefix(GPtrArray *dst, const char *name,
 	CopyInfo *info, guint max_num)
 {
@@ -774,87 +1635,133 @@ static void fill_find_tags_array_prefix(GPtrArray *dst, const char *name,
 	}
 	if (dst->len < max_num)
 	{
-		GHashTableIter iter;
-		gpointer key;
+		guint i;
 
-		g_hash_table_iter_init(&iter, info->includes);
-		while (g_hash_table_iter_next(&iter, &key, NULL))
+		for (i = 0; i < info->include_files->len && dst->len < max_num; i++)
 		{
-			TMSourceFile *include_file = key;
+			TMSourceFile *include_file = info->include_files->pdata[i];
 			found = tm_tags_find(include_file->tags_array, name, TRUE, &count);
 			if (found)
 				copy_tags(dst, found, count, name_table, max_num - dst->len, is_non_local_tag, info);
 		}
 	}
 	if (dst->len < max_num)
-	{
-		found = tm_tags_find(theWorkspace->tags_array, name, TRUE, &count);
-		if (found)
-			copy_tags(dst, found, count, name_table, max_num - dst->len, is_workspace_tag, info);
-	}
+		copy_lang_index_tags(dst, workspace_lang_index, name, name_table, max_num, is_workspace_tag, info);
 	if (dst->len < max_num)
-	{
-		found = tm_tags_find(theWorkspace->global_tags, name, TRUE, &count);
-		if (found)
-			copy_tags(dst, found, count, name_table, max_num - dst->len, is_any_tag, info);
-	}
+		copy_lang_index_tags(dst, global_lang_index, name, name_table, max_num, is_any_tag, info);
 
 	g_hash_table_unref(name_table);
 }
 
 
-/* return TMSourceFile files corresponding to files included in 'source';
- * in addition, fill header_candidates with TMSourceFiles that could be the header
- * of 'source' based on the file name */
-static GHashTable *get_includes(TMSourceFile *source, GPtrArray **header_candidates)
+/* Sets how deep the files included by included files are followed when looking
+ for the files included by a source file, 1 for direct includes only.
+ @param depth The maximum include depth. */
+void tm_workspace_set_include_depth(guint depth)
 {
-	GHashTable *includes = g_hash_table_new(NULL, NULL);
-	GPtrArray *headers;
-	gchar *src_basename, *ptr;
-	guint i;
+	depth = MAX(depth, 1);
+	if (depth != include_depth)
+	{
+		include_depth = depth;
+		includes_stamp++;
+	}
+}
 
-	*header_candidates = NULL;
 
-	if (!source ||
-		(source->lang != TM_PARSER_C && source->lang != TM_PARSER_CPP))
-		return includes;
+static void compute_includes(TMSourceFile *source, TMSourceFileIncludes *includes)
+{
+	GPtrArray *level = g_ptr_array_new();
+	gchar *src_basename, *ptr;
+	guint depth, i, j;
+
+	includes->files = g_ptr_array_new();
+	includes->depths = g_hash_table_new(NULL, NULL);
+	includes->header_candidates = NULL;
 
 	src_basename = g_strdup(source->short_name);
 	if ((ptr = strrchr(src_basename, '.')) != NULL)
 		*ptr = '\0';
 
-	headers = tm_tags_extract(source->tags_array, tm_tag_include_t);
-
-	for (i = 0; i < headers->len; i++)
+	/* breadth-first so that files end up ordered by their include depth */
+	g_ptr_array_add(level, source);
+	for (depth = 1; depth <= include_depth && level->len > 0; depth++)
 	{
-		TMTag *hdr_tag = headers->pdata[i];
-		gchar *hdr_name = g_path_get_basename(hdr_tag->name);
-		GPtrArray *tm_files = g_hash_table_lookup(theWorkspace->source_file_map, hdr_name);
+		guint level_end = level->len;
 
-		if (tm_files && tm_files->len > 0)
+		for (i = 0; i < level_end; i++)
 		{
-			guint j;
+			TMSourceFile *file = level->pdata[i];
 
-			if (!*header_candidates)
+			for (j = 0; j < file->tags_array->len; j++)
 			{
-				gchar *hdr_basename = g_strdup(hdr_name);
-				if ((ptr = strrchr(hdr_basename, '.')) != NULL)
-					*ptr = '\0';
+				TMTag *hdr_tag = file->tags_array->pdata[j];
+				gchar *hdr_name;
+				GPtrArray *tm_files;
+				guint k;
 
-				if (g_strcmp0(hdr_basename, src_basename) == 0)
-					*header_candidates = tm_files;
-				g_free(hdr_basename);
-			}
+				if (!(hdr_tag->type & tm_tag_include_t))
+					continue;
 
-			for (j = 0; j < tm_files->len; j++)
-				g_hash_table_add(includes, tm_files->pdata[j]);
-		}
+				hdr_name = g_path_get_basename(hdr_tag->name);
+				tm_files = g_hash_table_lookup(theWorkspace->source_file_map, hdr_name);
 
-		g_free(hdr_name);
+				if (tm_files && tm_files->len > 0 && depth == 1 && !includes->header_candidates)
+				{
+					gchar *hdr_basename = g_strdup(hdr_name);
+					if ((ptr = strrchr(hdr_basename, '.')) != NULL)
+						*ptr = '\0';
+
+					if (g_strcmp0(hdr_basename, src_basename) == 0)
+						includes->header_candidates = tm_files;
+					g_free(hdr_basename);
+				}
+
+				for (k = 0; tm_files && k < tm_files->len; k++)
+				{
+					TMSourceFile *include_file = tm_files->pdata[k];
+
+					if (include_file == source ||
+						g_hash_table_contains(includes->depths, include_file))
+						continue;
+
+					g_hash_table_insert(includes->depths, include_file, GUINT_TO_POINTER(depth));
+					g_ptr_array_add(includes->files, include_file);
+					g_ptr_array_add(level, include_file);
+				}
+
+				g_free(hdr_name);
+			}
+		}
+		g_ptr_array_remove_range(level, 0, level_end);
 	}
 
-	g_ptr_array_free(headers, TRUE);
+	g_ptr_array_free(level, TRUE);
 	g_free(src_basename);
+}
+
+
+/* return TMSourceFile files included in 'source' up to the configured include
+ * depth; in addition, header_candidates contains TMSourceFiles that could be
+ * the header of 'source' based on the file name. The result is cached on
+ * 'source' until its includes or the workspace files change. */
+static const TMSourceFileIncludes *get_includes(TMSourceFile *source)
+{
+	TMSourceFileIncludes *includes;
+
+	if (!source ||
+		(source->lang != TM_PARSER_C && source->lang != TM_PARSER_CPP))
+		return &no_includes;
+
+	includes = tm_source_file_get_includes(source);
+	if (includes->stamp != includes_stamp)
+	{
+		guint signature = includes->signature;
+
+		tm_source_file_clear_includes(source);
+		includes->signature = signature;
+		compute_includes(source, includes);
+		includes->stamp = includes_stamp;
+	}
 	return includes;
 }
 
@@ -873,11 +1780,12 @@ static gint sort_found_tags(gconstpointer a, gconstpointer b, gpointer user_data
 	SortInfo *info = user_data;
 	const TMTag *t1 = *((TMTag **) a);
 	const TMTag *t2 = *((TMTag **) b);
+	guint depth1, depth2;
 
 	/* sort local vars first (with highest line number first),
 	 * followed by tags from current file,
 	 * followed by tags from header,
-	 * followed by tags from other included files,
+	 * followed by tags from other included files (closest includes first),
 	 * followed by workspace tags,
 	 * followed by global tags */
 	if (t1->type & tm_tag_local_var_t && t2->type & tm_tag_local_var_t)
@@ -903,10 +1811,11 @@ static gint sort_found_tags(gconstpointer a, gconstpointer b, gpointer user_data
 			 g_ptr_array_find(info->header_candidates, t2->file, NULL) &&
 			 !g_ptr_array_find(info->header_candidates, t1->file, NULL))
 		return 1;
-	else if (g_hash_table_lookup(info->includes, t1->file) && !g_hash_table_lookup(info->includes, t2->file))
-		return -1;
-	else if (g_hash_table_lookup(info->includes, t2->file) && !g_hash_table_lookup(info->includes, t1->file))
-		return 1;
+
+	depth1 = GPOINTER_TO_UINT(g_hash_table_lookup(info->includes, t1->file));
+	depth2 = GPOINTER_TO_UINT(g_hash_table_lookup(info->includes, t2->file));
+	if (depth1 != depth2)
+		return (depth1 && (!depth2 || depth1 < depth2)) ? -1 : 1;
 	else if (t1->file && !t2->file)
 		return -1;
 	else if (t2->file && !t1->file)
@@ -931,14 +1840,14 @@ GPtrArray *tm_workspace_find_prefix(const char *prefix,
 	guint max_num)
 {
 	GPtrArray *tags = g_ptr_array_new();
-	GPtrArray *header_candidates;
+	const TMSourceFileIncludes *includes = get_includes(current_file);
 	SortInfo sort_info;
 	CopyInfo copy_info;
-	GHashTable *includes = get_includes(current_file, &header_candidates);
 
 	copy_info.file = current_file;
-	copy_info.header_candidates = header_candidates;
-	copy_info.includes = includes;
+	copy_info.header_candidates = includes->header_candidates;
+	copy_info.includes = includes->depths;
+	copy_info.include_files = includes->files;
 	copy_info.line = current_line;
 	copy_info.scope = current_scope;
 	fill_find_tags_array_prefix(tags, prefix, &copy_info, max_num);
@@ -946,12 +1855,368 @@ GPtrArray *tm_workspace_find_prefix(const char *prefix,
 	/* sort based on how "close" the tag is to current line with local
 	 * variables first */
 	sort_info.file = current_file;
-	sort_info.header_candidates = header_candidates;
-	sort_info.includes = includes;
+	sort_info.header_candidates = includes->header_candidates;
+	sort_info.includes = includes->depths;
 	sort_info.sort_by_name = TRUE;
 	g_ptr_array_sort_with_data(tags, sort_found_tags, &sort_info);
 
-	g_hash_table_destroy(includes);
+	return tags;
+}
+
+
+/* Scores name matching pattern as a case-insensitive subsequence, -1 if it
+ * doesn't match. Matched characters at the start of the name, at word starts
+ * (after non-alphanumeric characters or at lower-to-upper case changes) and
+ * consecutive matches score higher, unmatched characters lower the score a bit.
+ * The matching is greedy so it stays linear in the name length. */
+static gint fuzzy_score(const gchar *pattern, gsize pattern_len, const gchar *name)
+{
+	const gchar *p = pattern;
+	const gchar *n;
+	gboolean consecutive = FALSE;
+	gint score = 0;
+	gchar prev = '\0';
+
+	for (n = name; *n && *p; prev = *n, n++)
+	{
+		if (g_ascii_tolower(*n) != g_ascii_tolower(*p))
+		{
+			consecutive = FALSE;
+			continue;
+		}
+
+		score += 2;
+		if (n == name)
+			score += 16;
+		else if (!g_ascii_isalnum(prev) || (g_ascii_islower(prev) && g_ascii_isupper(*n)))
+			score += 10;
+		if (consecutive)
+			score += 8;
+		if (*n == *p)
+			score += 1;
+		consecutive = TRUE;
+		p++;
+	}
+
+	if (*p)
+		return -1;
+	/* prefer shorter names among otherwise equal matches */
+	return score * 8 - (gint) MIN(strlen(name) - pattern_len, 7);
+}
+
+
+typedef struct
+{
+	TMTag *tag;
+	gint score;
+	guint rank;  /* locality of the tag, lower is closer */
+} FuzzyMatch;
+
+typedef struct
+{
+	const gchar *pattern;
+	gsize pattern_len;
+	guint32 pattern_mask;
+	GArray *matches;  /* best matches first */
+	GHashTable *name_table;  /* names of the matches */
+	guint max_num;
+} FuzzyInfo;
+
+
+static void add_fuzzy_matches(FuzzyInfo *fuzzy, TMTag **tags, guint tags_len, guint rank,
+	gboolean (*predicate) (TMTag *, CopyInfo *), CopyInfo *info)
+{
+	const gchar *last_name = NULL;
+	gint last_score = -1;
+	guint i;
+
+	for (i = 0; i < tags_len; i++)
+	{
+		TMTag *tag = tags[i];
+		FuzzyMatch match;
+		guint pos;
+
+		if ((tm_tag_get_name_mask(tag) & fuzzy->pattern_mask) != fuzzy->pattern_mask)
+			continue;
+
+		/* tag arrays are sorted by name, don't score repeated names again */
+		if (last_name && (tag->name == last_name || strcmp(tag->name, last_name) == 0))
+			match.score = last_score;
+		else
+			match.score = fuzzy_score(fuzzy->pattern, fuzzy->pattern_len, tag->name);
+		last_name = tag->name;
+		last_score = match.score;
+		if (match.score < 0)
+			continue;
+
+		/* find the position, skipping the tags at least as good */
+		for (pos = fuzzy->matches->len; pos > 0; pos--)
+		{
+			FuzzyMatch *m = &g_array_index(fuzzy->matches, FuzzyMatch, pos - 1);
+			if (m->score > match.score || (m->score == match.score && m->rank <= rank))
+				break;
+		}
+		if (pos >= fuzzy->max_num)
+			continue;
+
+		if (!predicate(tag, info) ||
+			!tm_workspace_is_autocomplete_tag(tag, info->file, info->line, info->scope) ||
+			g_hash_table_contains(fuzzy->name_table, tag->name))
+			continue;
+
+		match.tag = tag;
+		match.rank = rank;
+		g_array_insert_val(fuzzy->matches, pos, match);
+		g_hash_table_add(fuzzy->name_table, tag->name);
+		if (fuzzy->matches->len > fuzzy->max_num)
+			g_array_set_size(fuzzy->matches, fuzzy->max_num);
+	}
+}
+
+
+static void add_fuzzy_lang_index_matches(FuzzyInfo *fuzzy, GHashTable *lang_index, guint rank,
+	gboolean (*predicate) (TMTag *, CopyInfo *), CopyInfo *info)
+{
+	TMParserType lang = info->file ? info->file->lang : TM_PARSER_NONE;
+	GHashTableIter iter;
+	gpointer key, value;
+
+	g_hash_table_iter_init(&iter, lang_index);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		GPtrArray *tags = value;
+
+		if (tm_parser_langs_compatible(lang, GPOINTER_TO_INT(key)))
+			add_fuzzy_matches(fuzzy, (TMTag **) tags->pdata, tags->len, rank, predicate, info);
+	}
+}
+
+
+static gint sort_fuzzy_matches(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	const FuzzyMatch *m1 = a;
+	const FuzzyMatch *m2 = b;
+
+	if (m1->score != m2->score)
+		return m2->score - m1->score;
+	return sort_found_tags(&m1->tag, &m2->tag, user_data);
+}
+
+
+/* Returns the tags whose names contain pattern as a subsequence (such as "gtb"
+ for "gtk_text_buffer" or "getTextBuffer"), best matches first. Equally good
+ matches are ordered by their locality like in tm_workspace_find_prefix().
+ @param pattern The typed text.
+ @param current_file The current file, only tags of compatible languages are returned.
+ @param current_line The current line number.
+ @param current_scope The current scope.
+ @param max_num The maximum number of returned tags.
+ @return Array of matching tags (with distinct names). */
+GPtrArray *tm_workspace_find_fuzzy(const char *pattern,
+	TMSourceFile *current_file,
+	guint current_line,
+	const gchar *current_scope,
+	guint max_num)
+{
+	GPtrArray *tags = g_ptr_array_new();
+	GPtrArray *header_candidates;
+	const TMSourceFileIncludes *includes;
+	FuzzyInfo fuzzy;
+	SortInfo sort_info;
+	CopyInfo copy_info;
+	guint i;
+
+	if (!pattern || !*pattern || max_num == 0)
+		return tags;
+
+	includes = get_includes(current_file);
+	header_candidates = includes->header_candidates;
+	copy_info.file = current_file;
+	copy_info.header_candidates = header_candidates;
+	copy_info.includes = includes->depths;
+	copy_info.include_files = includes->files;
+	copy_info.line = current_line;
+	copy_info.scope = current_scope;
+
+	fuzzy.pattern = pattern;
+	fuzzy.pattern_len = strlen(pattern);
+	fuzzy.pattern_mask = tm_tag_get_str_mask(pattern);
+	fuzzy.matches = g_array_sized_new(FALSE, FALSE, sizeof(FuzzyMatch), max_num + 1);
+	fuzzy.name_table = g_hash_table_new(g_str_hash, g_str_equal);
+	fuzzy.max_num = max_num;
+
+	/* visit the tags from the closest to the farthest so that closer tags win
+	 * among equally scored tags of the same name */
+	if (current_file)
+	{
+		GPtrArray *file_tags = current_file->tags_array;
+
+		add_fuzzy_matches(&fuzzy, (TMTag **) file_tags->pdata, file_tags->len, 0, is_local_tag, &copy_info);
+		add_fuzzy_matches(&fuzzy, (TMTag **) file_tags->pdata, file_tags->len, 1, is_non_local_tag, &copy_info);
+	}
+	for (i = 0; header_candidates && i < header_candidates->len; i++)
+	{
+		TMSourceFile *hdr = header_candidates->pdata[i];
+
+		add_fuzzy_matches(&fuzzy, (TMTag **) hdr->tags_array->pdata, hdr->tags_array->len, 2,
+			is_non_local_tag, &copy_info);
+	}
+	for (i = 0; i < includes->files->len; i++)
+	{
+		TMSourceFile *include_file = includes->files->pdata[i];
+
+		add_fuzzy_matches(&fuzzy, (TMTag **) include_file->tags_array->pdata,
+			include_file->tags_array->len, 3, is_non_local_tag, &copy_info);
+	}
+	add_fuzzy_lang_index_matches(&fuzzy, workspace_lang_index, 4, is_workspace_tag, &copy_info);
+	add_fuzzy_lang_index_matches(&fuzzy, global_lang_index, 5, is_any_tag, &copy_info);
+
+	sort_info.file = current_file;
+	sort_info.header_candidates = header_candidates;
+	sort_info.includes = includes->depths;
+	sort_info.sort_by_name = TRUE;
+	g_array_sort_with_data(fuzzy.matches, sort_fuzzy_matches, &sort_info);
+
+	for (i = 0; i < fuzzy.matches->len; i++)
+		g_ptr_array_add(tags, g_array_index(fuzzy.matches, FuzzyMatch, i).tag);
+
+	g_array_free(fuzzy.matches, TRUE);
+	g_hash_table_destroy(fuzzy.name_table);
+
+	return tags;
+}
+
+
+static gboolean is_symbol_tag(TMTag *tag)
+{
+	return !(tag->type & (tm_tag_local_var_t | tm_tag_include_t | tm_tag_undef_t));
+}
+
+
+/* Gets the tags of all whose names match pattern as a subsequence, either by
+ * filtering the matches of the previous query when pattern extends its pattern,
+ * or by walking all tags */
+static GPtrArray *get_symbol_candidates(SymbolQuery *query, GPtrArray *all, const gchar *pattern)
+{
+	guint32 pattern_mask = tm_tag_get_str_mask(pattern);
+	gsize pattern_len = strlen(pattern);
+	const gchar *last_name = NULL;
+	gboolean last_match = FALSE;
+	GPtrArray *src = all;
+	GPtrArray *tags;
+	guint i;
+
+	if (query->tags && query->stamp == symbols_stamp &&
+		g_ascii_strncasecmp(pattern, query->pattern, strlen(query->pattern)) == 0)
+	{
+		if (strcmp(pattern, query->pattern) == 0)
+			return query->tags;
+		src = query->tags;
+	}
+
+	tags = g_ptr_array_new();
+	for (i = 0; i < src->len; i++)
+	{
+		TMTag *tag = src->pdata[i];
+
+		if (src == all &&
+			(!is_symbol_tag(tag) || (tm_tag_get_name_mask(tag) & pattern_mask) != pattern_mask))
+			continue;
+
+		/* tag arrays are sorted by name, don't match repeated names again */
+		if (!last_name || (tag->name != last_name && strcmp(tag->name, last_name) != 0))
+			last_match = fuzzy_score(pattern, pattern_len, tag->name) >= 0;
+		last_name = tag->name;
+		if (last_match)
+			g_ptr_array_add(tags, tag);
+	}
+
+	if (query->tags)
+		g_ptr_array_free(query->tags, TRUE);
+	g_free(query->pattern);
+	query->tags = tags;
+	query->pattern = g_strdup(pattern);
+	query->stamp = symbols_stamp;
+	return tags;
+}
+
+
+static gint compare_symbol_matches(const FuzzyMatch *m1, const FuzzyMatch *m2)
+{
+	const gchar *f1 = m1->tag->file ? m1->tag->file->file_name : "";
+	const gchar *f2 = m2->tag->file ? m2->tag->file->file_name : "";
+	gint ret;
+
+	if (m1->score != m2->score)
+		return m2->score - m1->score;
+	ret = strcmp(m1->tag->name, m2->tag->name);
+	if (ret == 0)
+		ret = strcmp(f1, f2);
+	if (ret == 0)
+		ret = m1->tag->line < m2->tag->line ? -1 : m1->tag->line > m2->tag->line;
+	return ret;
+}
+
+
+/* Returns the workspace or global tags usable as go-to targets whose names
+ contain pattern as a subsequence, best matches first, equally good matches
+ sorted by name, file name and line. Only the tags of the previous matches are
+ examined again when the pattern is extended by typing, and the tag arrays are
+ updated in place on reparse, so the queries stay cheap while typing.
+ @param pattern The typed text.
+ @param global Whether to search the global tags instead of the workspace tags.
+ @param max_num The maximum number of returned tags.
+ @return Array of matching tags. */
+GPtrArray *tm_workspace_find_symbols(const char *pattern, gboolean global, guint max_num)
+{
+	GPtrArray *all = global ? theWorkspace->global_tags : theWorkspace->tags_array;
+	GPtrArray *candidates;
+	GArray *matches;
+	GPtrArray *tags;
+	gsize pattern_len;
+	const gchar *last_name = NULL;
+	gint last_score = -1;
+	guint i;
+
+	if (!pattern || !*pattern || max_num == 0)
+		return g_ptr_array_new();
+
+	candidates = get_symbol_candidates(&symbol_queries[global ? 1 : 0], all, pattern);
+	pattern_len = strlen(pattern);
+	matches = g_array_sized_new(FALSE, FALSE, sizeof(FuzzyMatch), max_num + 1);
+
+	for (i = 0; i < candidates->len; i++)
+	{
+		FuzzyMatch match;
+		guint pos;
+
+		match.tag = candidates->pdata[i];
+		match.rank = 0;
+		if (last_name && (match.tag->name == last_name || strcmp(match.tag->name, last_name) == 0))
+			match.score = last_score;
+		else
+			match.score = fuzzy_score(pattern, pattern_len, match.tag->name);
+		last_name = match.tag->name;
+		last_score = match.score;
+
+		/* keep the best max_num matches sorted */
+		for (pos = matches->len; pos > 0; pos--)
+		{
+			if (compare_symbol_matches(&g_array_index(matches, FuzzyMatch, pos - 1), &match) <= 0)
+				break;
+		}
+		if (pos >= max_num)
+			continue;
+
+		g_array_insert_val(matches, pos, match);
+		if (matches->len > max_num)
+			g_array_set_size(matches, max_num);
+	}
+
+	tags = g_ptr_array_sized_new(matches->len);
+	for (i = 0; i < matches->len; i++)
+		g_ptr_array_add(tags, g_array_index(matches, FuzzyMatch, i).tag);
+	g_array_free(matches, TRUE);
 
 	return tags;
 }
@@ -1041,6 +2306,7 @@ static GPtrArray *
 find_scope_members_tags (const GPtrArray *all, TMTag *type_tag, gboolean namespace, guint depth)
 {
 	TMTagType member_types = tm_tag_max_t & ~(TM_TYPE_WITH_MEMBERS | tm_tag_typedef_t);
+	const GPtrArray *candidates = all;
 	GPtrArray *tags;
 	gchar *scope;
 	guint i;
@@ -1058,9 +2324,18 @@ find_scope_members_tags (const GPtrArray *all, TMTag *type_tag, gboolean namespa
 	else
 		scope = g_strdup(type_tag->name);
 
-	for (i = 0; i < all->len; ++i)
+	/* only walk the tags with the right scope for the big arrays */
+	if (all == theWorkspace->tags_array || all == theWorkspace->global_tags)
 	{
-		TMTag *tag = TM_TAG (all->pdata[i]);
+		GHashTable *scope_index = (all == theWorkspace->tags_array) ?
+			workspace_scope_index : global_scope_index;
+
+		candidates = g_hash_table_lookup(scope_index, scope);
+	}
+
+	for (i = 0; candidates && i < candidates->len; ++i)
+	{
+		TMTag *tag = TM_TAG (candidates->pdata[i]);
 
 		if (tag && (tag->type & member_types) &&
 			tag->scope && tag->scope[0] != '\0' &&
@@ -1353,6 +2628,7 @@ tm_workspace_find_scope_members (TMSourceFile *source_file, const char *name,
 
 	if (!member_tags)
 	{
+		const TMSourceFileIncludes *includes;
 		SortInfo info;
 		guint i;
 
@@ -1373,7 +2649,9 @@ tm_workspace_find_scope_members (TMSourceFile *source_file, const char *name,
 
 		info.file = source_file;
 		info.sort_by_name = FALSE;
-		info.includes = get_includes(source_file, &info.header_candidates);
+		includes = get_includes(source_file);
+		info.header_candidates = includes->header_candidates;
+		info.includes = includes->depths;
 		g_ptr_array_sort_with_data(tags, sort_found_tags, &info);
 
 		/* Start searching inside the source file, continue with workspace tags and
@@ -1390,7 +2668,6 @@ tm_workspace_find_scope_members (TMSourceFile *source_file, const char *name,
 												 member, current_scope);
 
 		g_ptr_array_free(tags, TRUE);
-		g_hash_table_destroy(info.includes);
 	}
 
 	if (member_tags)
@@ -1405,7 +2682,8 @@ tm_workspace_find_scope_members (TMSourceFile *source_file, const char *name,
 /* Dumps the workspace tree - useful for debugging */
 void tm_workspace_dump(void)
 {
-	guint i;
+	guint i, string_count;
+	gsize string_size, string_saved;
 
 #ifdef TM_DEBUG
 	g_message("Dumping TagManager workspace tree..");
@@ -1415,5 +2693,11 @@ void tm_workspace_dump(void)
 		TMSourceFile *source_file = theWorkspace->source_files->pdata[i];
 		fprintf(stderr, "%s", source_file->file_name);
 	}
+
+	tm_tag_get_string_pool_stats(&string_count, &string_size, &string_saved);
+	fprintf(stderr, "\n%u workspace tags, %u global tags\n", theWorkspace->tags_array->len,
+		theWorkspace->global_tags->len);
+	fprintf(stderr, "%u interned tag strings using %" G_GSIZE_FORMAT " bytes, "
+		"%" G_GSIZE_FORMAT " bytes saved by interning\n", string_count, string_size, string_saved);
 }
 #endif /* TM_DEBUG */
@@ -47,12 +47,19 @@ void tm_workspace_remove_source_files(GPtrArray *source_files);
 
 #ifdef GEANY_PRIVATE
 
+/* Called in the main loop when a background parse of source_file has been merged
+ * into the workspace */
+typedef void (*TMParseCallback)(TMSourceFile *source_file, gpointer user_data);
+
 const TMWorkspace *tm_get_workspace(void);
 
 gboolean tm_workspace_load_global_tags(const char *tags_file, TMParserType mode);
 
+guint tm_workspace_load_global_tags_files(const gchar **tags_files, const TMParserType *modes,
+	guint count, gint *tag_counts);
+
 gboolean tm_workspace_create_global_tags(const char *pre_process, const char **includes,
-	int includes_count, const char *tags_file, TMParserType lang);
+	int includes_count, const char *tags_file, TMParserType lang, gboolean binary);
 
 GPtrArray *tm_workspace_find(const char *name, const char *scope, TMTagType type,
 	TMTagAttrType *attrs, TMParserType lang);
@@ -61,15 +68,36 @@ GPtrArray *tm_workspace_find_prefix(const char *prefix,
 	TMSourceFile *current_file, guint current_line, const gchar *current_scope,
 	guint max_num);
 
+GPtrArray *tm_workspace_find_fuzzy(const char *pattern,
+	TMSourceFile *current_file, guint current_line, const gchar *current_scope,
+	guint max_num);
+
+GPtrArray *tm_workspace_find_symbols(const char *pattern, gboolean global, guint max_num);
+
 GPtrArray *tm_workspace_find_scope_members (TMSourceFile *source_file, const char *name,
 	gboolean function, gboolean member, const gchar *current_scope, guint current_line, gboolean search_namespace);
 
 
 void tm_workspace_add_source_file_noupdate(TMSourceFile *source_file);
 
+gboolean tm_workspace_add_source_files_async(GPtrArray *source_files, gboolean update);
+
+void tm_workspace_update(void);
+
 void tm_workspace_update_source_file_buffer(TMSourceFile *source_file, guchar* text_buf,
 	gsize buf_size);
 
+void tm_workspace_update_source_file_buffer_async(TMSourceFile *source_file,
+	GBytes *bytes, gboolean use_cache, TMParseCallback callback, gpointer user_data);
+
+void tm_workspace_set_parse_workers(guint num_workers);
+
+gboolean tm_workspace_parses_in_background(TMSourceFile *source_file);
+
+void tm_workspace_set_include_depth(guint depth);
+
+guint tm_workspace_get_typenames_version(TMParserType lang);
+
 void tm_workspace_free(void);
 
 gboolean tm_workspace_is_autocomplete_tag(TMTag *tag, TMSourceFile *current_file,
@@ -0,0 +1,359 @@
+/*
+ *      bench_tagmanager.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Micro-benchmarks of the tag manager. A synthetic workspace of generated
+ * source files is parsed and the main workspace and tag array operations are
+ * timed. The results are printed as JSON to stdout.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "tm_source_file.h"
+#include "tm_tag.h"
+#include "tm_workspace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#ifdef G_OS_UNIX
+# include <sys/resource.h>
+#endif
+
+
+/* must match the sort order of the workspace tags in tm_workspace.c */
+static TMTagAttrType sort_attrs[] =
+{
+	tm_tag_attr_name_t, tm_tag_attr_file_t, tm_tag_attr_line_t,
+	tm_tag_attr_type_t, tm_tag_attr_scope_t, tm_tag_attr_arglist_t, 0
+};
+
+/* each unit of a generated file results in 4 tags: a type with two members
+ * and a function */
+#define TAGS_PER_UNIT 4
+
+static const gchar *lang_names[] = { "C", "Python", "JavaScript" };
+static const gchar *lang_extensions[] = { "c", "py", "js" };
+
+static gint num_files = 200;
+static gint num_tags = 400;
+static gint num_languages = 1;
+static gdouble min_time = 0.5;
+
+static GOptionEntry entries[] =
+{
+	{ "files", 'f', 0, G_OPTION_ARG_INT, &num_files, "Number of source files (default 200)", "N" },
+	{ "tags", 't', 0, G_OPTION_ARG_INT, &num_tags, "Number of tags per file (default 400)", "N" },
+	{ "languages", 'l', 0, G_OPTION_ARG_INT, &num_languages,
+		"Number of languages, C, Python and JavaScript (default 1)", "N" },
+	{ "min-time", 'm', 0, G_OPTION_ARG_DOUBLE, &min_time,
+		"Minimum time in seconds each benchmark runs (default 0.5)", "SECONDS" },
+	{ NULL }
+};
+
+
+typedef struct
+{
+	gchar *dir;
+	GPtrArray *source_files;
+	GPtrArray *contents;  /* the contents of source_files */
+} Workspace;
+
+typedef struct
+{
+	const gchar *name;
+	guint64 ops;
+	gdouble seconds;
+} Result;
+
+typedef guint (*BenchFunc)(Workspace *ws, guint iteration);
+
+
+static void append_unit(GString *str, guint lang, guint file, guint unit)
+{
+	switch (lang)
+	{
+		case 0:
+			g_string_append_printf(str,
+				"struct bench_type_%u_%u {\n"
+				"\tint member_a;\n"
+				"\tint member_b;\n"
+				"};\n"
+				"int bench_func_%u_%u(struct bench_type_%u_%u *arg);\n\n",
+				file, unit, file, unit, file, unit);
+			break;
+		case 1:
+			g_string_append_printf(str,
+				"class bench_type_%u_%u:\n"
+				"    def member_a(self):\n"
+				"        pass\n"
+				"    def member_b(self):\n"
+				"        pass\n\n"
+				"def bench_func_%u_%u(arg):\n"
+				"    pass\n\n",
+				file, unit, file, unit);
+			break;
+		default:
+			g_string_append_printf(str,
+				"class bench_type_%u_%u {\n"
+				"\tmember_a() {}\n"
+				"\tmember_b() {}\n"
+				"}\n"
+				"function bench_func_%u_%u(arg) {}\n\n",
+				file, unit, file, unit);
+			break;
+	}
+}
+
+
+static void workspace_create(Workspace *ws)
+{
+	guint units = MAX(num_tags / TAGS_PER_UNIT, 1);
+	guint i, j;
+
+	ws->dir = g_dir_make_tmp("geany-bench-XXXXXX", NULL);
+	g_assert_nonnull(ws->dir);
+	ws->source_files = g_ptr_array_new();
+	ws->contents = g_ptr_array_new_with_free_func(g_free);
+
+	for (i = 0; i < (guint) num_files; i++)
+	{
+		guint lang = i % (guint) num_languages;
+		gchar *name = g_strdup_printf("file%u.%s", i, lang_extensions[lang]);
+		gchar *path = g_build_filename(ws->dir, name, NULL);
+		GString *str = g_string_new(NULL);
+		TMSourceFile *source_file;
+
+		for (j = 0; j < units; j++)
+			append_unit(str, lang, i, j);
+		g_assert_true(g_file_set_contents(path, str->str, str->len, NULL));
+
+		source_file = tm_source_file_new(path, lang_names[lang]);
+		g_assert_nonnull(source_file);
+		g_ptr_array_add(ws->source_files, source_file);
+		g_ptr_array_add(ws->contents, g_string_free(str, FALSE));
+
+		g_free(path);
+		g_free(name);
+	}
+}
+
+
+static void workspace_destroy(Workspace *ws)
+{
+	guint i;
+
+	tm_workspace_remove_source_files(ws->source_files);
+	for (i = 0; i < ws->source_files->len; i++)
+	{
+		TMSourceFile *source_file = ws->source_files->pdata[i];
+
+		g_unlink(source_file->file_name);
+		tm_source_file_free(source_file);
+	}
+	g_rmdir(ws->dir);
+
+	g_ptr_array_free(ws->source_files, TRUE);
+	g_ptr_array_free(ws->contents, TRUE);
+	g_free(ws->dir);
+}
+
+
+static guint bench_add_source_files(Workspace *ws, guint iteration)
+{
+	/* the first iteration adds the files which stay in the workspace for
+	 * the other benchmarks */
+	if (iteration > 0)
+		tm_workspace_remove_source_files(ws->source_files);
+	tm_workspace_add_source_files(ws->source_files);
+	return ws->source_files->len;
+}
+
+
+static guint bench_update_source_file(Workspace *ws, guint iteration)
+{
+	guint i = iteration % ws->source_files->len;
+	gchar *contents = ws->contents->pdata[i];
+
+	tm_workspace_update_source_file_buffer(ws->source_files->pdata[i],
+		(guchar *) contents, strlen(contents));
+	return 1;
+}
+
+
+static GPtrArray *copy_workspace_tags(void)
+{
+	GPtrArray *workspace_tags = tm_get_workspace()->tags_array;
+	GPtrArray *tags = g_ptr_array_sized_new(workspace_tags->len);
+
+	g_ptr_array_set_size(tags, workspace_tags->len);
+	memcpy(tags->pdata, workspace_tags->pdata, workspace_tags->len * sizeof(gpointer));
+	return tags;
+}
+
+
+static guint bench_tags_merge(Workspace *ws, guint iteration)
+{
+	TMSourceFile *source_file = ws->source_files->pdata[iteration % ws->source_files->len];
+	GPtrArray *tags = copy_workspace_tags();
+	GPtrArray *merged;
+
+	/* merge the tags of a file back into the workspace tags without them */
+	tm_tags_remove_file_tags(source_file, tags);
+	tm_tags_prune(tags);
+	merged = tm_tags_merge(tags, source_file->tags_array, sort_attrs, FALSE);
+
+	g_ptr_array_free(merged, TRUE);
+	g_ptr_array_free(tags, TRUE);
+	return 1;
+}
+
+
+static guint bench_tags_remove_file_tags(Workspace *ws, guint iteration)
+{
+	TMSourceFile *source_file = ws->source_files->pdata[iteration % ws->source_files->len];
+	GPtrArray *tags = copy_workspace_tags();
+
+	tm_tags_remove_file_tags(source_file, tags);
+
+	g_ptr_array_free(tags, TRUE);
+	return 1;
+}
+
+
+static guint bench_find_prefix(Workspace *ws, guint iteration)
+{
+	gchar *prefix = g_strdup_printf("bench_func_%u", iteration % ws->source_files->len);
+	GPtrArray *tags;
+
+	tags = tm_workspace_find_prefix(prefix, ws->source_files->pdata[0], 1, NULL, 50);
+	g_ptr_array_free(tags, TRUE);
+
+	g_free(prefix);
+	return 1;
+}
+
+
+static guint bench_find_scope_members(Workspace *ws, guint iteration)
+{
+	guint file = iteration % ws->source_files->len;
+	gchar *name = g_strdup_printf("bench_type_%u_0", file);
+	GPtrArray *tags;
+
+	tags = tm_workspace_find_scope_members(ws->source_files->pdata[file], name,
+		FALSE, FALSE, NULL, 1, FALSE);
+	if (tags)
+		g_ptr_array_free(tags, TRUE);
+
+	g_free(name);
+	return 1;
+}
+
+
+/* Runs func until it ran at least min_time seconds */
+static void run(Workspace *ws, Result *result, const gchar *name, BenchFunc func)
+{
+	gint64 start = g_get_monotonic_time();
+	gint64 end = start + (gint64) (min_time * G_USEC_PER_SEC);
+	gint64 now;
+	guint iteration = 0;
+
+	result->name = name;
+	result->ops = 0;
+	do
+	{
+		result->ops += func(ws, iteration++);
+		now = g_get_monotonic_time();
+	}
+	while (now < end);
+	result->seconds = (now - start) / (gdouble) G_USEC_PER_SEC;
+}
+
+
+/* Returns the peak resident set size of the process in KiB, or -1 if unknown */
+static glong get_peak_rss(void)
+{
+#ifdef G_OS_UNIX
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+# ifdef __APPLE__
+		return usage.ru_maxrss / 1024;
+# else
+		return usage.ru_maxrss;
+# endif
+#endif
+	return -1;
+}
+
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	Workspace ws;
+	Result results[6];
+	guint i;
+
+	context = g_option_context_new("- benchmark the tag manager");
+	g_option_context_add_main_entries(context, entries, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error))
+	{
+		g_printerr("%s\n", error->message);
+		g_error_free(error);
+		return 1;
+	}
+	g_option_context_free(context);
+	num_files = MAX(num_files, 1);
+	num_languages = CLAMP(num_languages, 1, (gint) G_N_ELEMENTS(lang_names));
+
+	/* creates the workspace, parses synchronously without parser threads */
+	tm_get_workspace();
+	workspace_create(&ws);
+
+	run(&ws, &results[0], "tm_workspace_add_source_files", bench_add_source_files);
+	run(&ws, &results[1], "update_source_file", bench_update_source_file);
+	run(&ws, &results[2], "tm_tags_merge", bench_tags_merge);
+	run(&ws, &results[3], "tm_tags_remove_file_tags", bench_tags_remove_file_tags);
+	run(&ws, &results[4], "tm_workspace_find_prefix", bench_find_prefix);
+	run(&ws, &results[5], "tm_workspace_find_scope_members", bench_find_scope_members);
+
+	printf("{\n");
+	printf("  \"files\": %d,\n", num_files);
+	printf("  \"tags_per_file\": %d,\n", MAX(num_tags / TAGS_PER_UNIT, 1) * TAGS_PER_UNIT);
+	printf("  \"languages\": %d,\n", num_languages);
+	printf("  \"workspace_tags\": %u,\n", tm_get_workspace()->tags_array->len);
+	printf("  \"benchmarks\": [\n");
+	for (i = 0; i < G_N_ELEMENTS(results); i++)
+	{
+		printf("    {\"name\": \"%s\", \"ops\": %" G_GUINT64_FORMAT ", \"seconds\": %.3f, "
+			"\"ops_per_sec\": %.1f}%s\n", results[i].name, results[i].ops, results[i].seconds,
+			results[i].ops / results[i].seconds, i + 1 < G_N_ELEMENTS(results) ? "," : "");
+	}
+	printf("  ],\n");
+	printf("  \"peak_rss_kib\": %ld\n", get_peak_rss());
+	printf("}\n");
+
+	workspace_destroy(&ws);
+	tm_workspace_free();
+	return 0;
+}